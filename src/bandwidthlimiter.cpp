@@ -0,0 +1,86 @@
+#include "bandwidthlimiter.h"
+#include "logger.h"
+
+BandwidthLimiter *BandwidthLimiter::myInstance = NULL;
+BandwidthLimiter *BandwidthLimiter::instance()
+{
+    if (myInstance == NULL)
+    {
+        myInstance = new BandwidthLimiter();
+    }
+    return myInstance;
+}
+
+BandwidthLimiter::BandwidthLimiter(QObject *parent) : QObject(parent)
+{
+    bytesPerSecond = 0;
+    capacity = 0;
+    tokens = 0;
+}
+
+void BandwidthLimiter::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("BandwidthLimiter"), text);
+}
+
+void BandwidthLimiter::setLimit(int rate)
+{
+    qint64 newRate = qint64( qMax(rate, 0) ) * 1024;
+    if (newRate == bytesPerSecond)
+    {
+        return;
+    }
+
+    if (newRate > 0)
+    {
+        log( tr("Downloads are limited to %1 KB/s.").arg(rate) );
+    }
+    else
+    {
+        log( tr("Downloads are not limited.") );
+    }
+
+    bytesPerSecond = newRate;
+    capacity = qMax(bytesPerSecond / burstDivider, qint64(minBurst));
+
+    // Start with a full bucket, so small requests don't wait
+    tokens = capacity;
+    refillTimer.start();
+}
+
+bool BandwidthLimiter::isLimited() const
+{
+    return bytesPerSecond > 0;
+}
+
+qint64 BandwidthLimiter::take(qint64 wanted)
+{
+    if ( !isLimited() )
+    {
+        return wanted;
+    }
+
+    refill();
+
+    qint64 granted = qBound(qint64(0), wanted, tokens);
+    tokens -= granted;
+
+    return granted;
+}
+
+void BandwidthLimiter::charge(qint64 bytes)
+{
+    if ( isLimited() )
+    {
+        refill();
+
+        // Debt is paid by the following requests
+        tokens -= bytes;
+    }
+}
+
+void BandwidthLimiter::refill()
+{
+    qint64 elapsed = refillTimer.restart();
+    tokens = qMin(capacity, tokens + elapsed * bytesPerSecond / 1000);
+}
@@ -0,0 +1,47 @@
+#ifndef BANDWIDTHLIMITER_H
+#define BANDWIDTHLIMITER_H
+
+#include <QtCore>
+
+// Token bucket shared by all downloads of the launcher.
+// Used from the main thread only, like the network access manager
+class BandwidthLimiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static BandwidthLimiter *instance();
+
+    // Rate in KB/s, zero disables the limit
+    void setLimit(int rate);
+    bool isLimited() const;
+
+    // Returns how many of wanted bytes may be read now
+    qint64 take(qint64 wanted);
+
+    // Accounts bytes which had to be read regardless of the limit
+    void charge(qint64 bytes);
+
+private:
+    explicit BandwidthLimiter(QObject *parent = 0);
+
+    static BandwidthLimiter *myInstance;
+
+    // Bucket holds at most this part of a second of traffic
+    static const int burstDivider = 4;
+    static const int minBurst = 16 * 1024;
+
+    qint64 bytesPerSecond;
+    qint64 capacity;
+    qint64 tokens;
+
+    QElapsedTimer refillTimer;
+
+    void refill();
+    void log(const QString &text);
+
+    BandwidthLimiter &operator=(BandwidthLimiter const &);
+    BandwidthLimiter(BandwidthLimiter const &);
+};
+
+#endif // BANDWIDTHLIMITER_H
@@ -0,0 +1,132 @@
+#include "crashwatcher.h"
+
+#include <algorithm>
+
+static const QString reportsDirName = "crash-reports";
+
+CrashWatcher::CrashWatcher(QObject *parent) : QObject(parent)
+{
+    connect(&watcher, &QFileSystemWatcher::directoryChanged,
+            this, &CrashWatcher::onDirectoryChanged);
+}
+
+void CrashWatcher::start(const QString &prefix)
+{
+    this->prefix = prefix;
+    knownReports = findReports(prefix);
+
+    // Fatal error logs are written to the working directory
+    watcher.addPath(prefix);
+
+    QString reportsDir = prefix + "/" + reportsDirName;
+    if ( QFileInfo(reportsDir).isDir() )
+    {
+        watcher.addPath(reportsDir);
+    }
+}
+
+void CrashWatcher::stop()
+{
+    QStringList paths = watcher.directories();
+    if ( !paths.isEmpty() )
+    {
+        watcher.removePaths(paths);
+    }
+}
+
+void CrashWatcher::check()
+{
+    if ( !prefix.isEmpty() )
+    {
+        onDirectoryChanged();
+    }
+}
+
+void CrashWatcher::onDirectoryChanged()
+{
+    // Reports directory is created by the first crash of the client
+    QString reportsDir = prefix + "/" + reportsDirName;
+    if ( QFileInfo(reportsDir).isDir()
+         && !watcher.directories().contains(reportsDir) )
+    {
+        watcher.addPath(reportsDir);
+    }
+
+    foreach ( QString path, findReports(prefix) )
+    {
+        if ( !knownReports.contains(path) )
+        {
+            knownReports << path;
+            emit reportFound(path);
+        }
+    }
+}
+
+QStringList CrashWatcher::findReports(const QString &prefix)
+{
+    QFileInfoList reports;
+
+    QDir reportsDir(prefix + "/" + reportsDirName);
+    reports << reportsDir.entryInfoList(QStringList() << "crash-*.txt",
+                                        QDir::Files);
+
+    QDir prefixDir(prefix);
+    reports << prefixDir.entryInfoList(QStringList() << "hs_err_pid*.log",
+                                       QDir::Files);
+
+    std::sort(reports.begin(), reports.end(),
+              [](const QFileInfo &a, const QFileInfo &b)
+    {
+        return a.lastModified() > b.lastModified();
+    });
+
+    QStringList paths;
+    foreach (const QFileInfo &info, reports)
+    {
+        paths << info.absoluteFilePath();
+    }
+
+    return paths;
+}
+
+QString CrashWatcher::describeReport(const QString &path)
+{
+    QFile file(path);
+    if ( !file.open(QIODevice::ReadOnly | QIODevice::Text) )
+    {
+        return "";
+    }
+
+    // Only the head of a report is read, the rest is a long dump
+    static const int maxLines = 40;
+
+    QTextStream stream(&file);
+    QString reason;
+
+    for (int i = 0; i < maxLines && !stream.atEnd(); i++)
+    {
+        QString line = stream.readLine().trimmed();
+
+        // Minecraft crash report: "Description: ..." and exception below
+        if ( line.startsWith("Description:") )
+        {
+            reason = line.mid( QString("Description:").length() ).trimmed();
+            continue;
+        }
+
+        if ( !reason.isEmpty() && !line.isEmpty() )
+        {
+            return reason + ": " + line;
+        }
+
+        // JVM fatal error log: "#  SIGSEGV (0xb) at pc=..."
+        // or "# java.lang.OutOfMemoryError: ..."
+        if ( line.startsWith("#  SIG") || line.startsWith("#  EXCEPTION")
+             || line.contains("OutOfMemoryError") )
+        {
+            return line.mid(1).trimmed();
+        }
+    }
+
+    return reason;
+}
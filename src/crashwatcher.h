@@ -0,0 +1,40 @@
+#ifndef CRASHWATCHER_H
+#define CRASHWATCHER_H
+
+#include <QtCore>
+
+// Watches client prefix for crash reports and JVM fatal error logs
+// which appear during a game session
+class CrashWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CrashWatcher(QObject *parent = 0);
+
+    void start(const QString &prefix);
+    void stop();
+
+    // Scans the prefix now, events may come after the game has finished
+    void check();
+
+    // Crash reports and fatal error logs, newest first
+    static QStringList findReports(const QString &prefix);
+
+    // Short reason of the crash, such as the exception or signal
+    static QString describeReport(const QString &path);
+
+signals:
+    void reportFound(const QString &path);
+
+private:
+    QFileSystemWatcher watcher;
+
+    QString prefix;
+    QStringList knownReports;
+
+private slots:
+    void onDirectoryChanged();
+};
+
+#endif // CRASHWATCHER_H
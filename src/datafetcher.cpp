@@ -1,18 +1,30 @@
 #include "datafetcher.h"
 #include "settings.h"
+#include "bandwidthlimiter.h"
+#include "mirrorlist.h"
 
 DataFetcher::DataFetcher(QObject *parent) : QObject(parent)
 {
     waiting = false;
+    failoverEnabled = true;
+    method = MethodGet;
     reset();
 
     nam = Settings::instance()->getNetworkAccessManager();
     logger = Logger::logger();
     timer = new QTimer(this);
+
+    throttleTimer = new QTimer(this);
+    throttleTimer->setSingleShot(true);
+    throttleTimer->setInterval(throttleInterval);
+
+    connect(throttleTimer, &QTimer::timeout,
+            this, &DataFetcher::onReadyRead);
 }
 
 DataFetcher::~DataFetcher()
 {
+    delete throttleTimer;
     delete timer;
 }
 
@@ -45,6 +57,11 @@ void DataFetcher::handleReply()
     connect(reply, &QNetworkReply::readyRead,
             this, &DataFetcher::stopTimer);
 
+    reply->setReadBufferSize(readBufferSize);
+
+    connect(reply, &QNetworkReply::readyRead,
+            this, &DataFetcher::onReadyRead);
+
     connect(reply, &QNetworkReply::finished,
             this, &DataFetcher::onRequestFinished);
 
@@ -64,6 +81,11 @@ void DataFetcher::unhandleReply()
     disconnect(reply, &QNetworkReply::readyRead,
                this, &DataFetcher::stopTimer);
 
+    throttleTimer->stop();
+
+    disconnect(reply, &QNetworkReply::readyRead,
+               this, &DataFetcher::onReadyRead);
+
     disconnect(reply, &QNetworkReply::finished,
                this, &DataFetcher::onRequestFinished);
 
@@ -94,8 +116,10 @@ void DataFetcher::makeHead(const QUrl &url)
     log( tr("Make HEAD request: %1").arg( url.toString() ) );
 
     reset();
-    reply = nam->head( QNetworkRequest(url) );
-    handleReply();
+
+    method = MethodHead;
+    requestUrl = url;
+    send();
 }
 
 void DataFetcher::makeGet(const QUrl &url)
@@ -103,10 +127,39 @@ void DataFetcher::makeGet(const QUrl &url)
     log( tr("Make GET request: %1").arg( url.toString() ) );
 
     reset();
-    reply = nam->get( QNetworkRequest(url) );
+
+    method = MethodGet;
+    requestUrl = url;
+    send();
+}
+
+void DataFetcher::send()
+{
+    if (method == MethodHead)
+    {
+        reply = nam->head( QNetworkRequest(requestUrl) );
+    }
+    else
+    {
+        reply = nam->get( QNetworkRequest(requestUrl) );
+    }
+
     handleReply();
 }
 
+void DataFetcher::setFailoverEnabled(bool state)
+{
+    failoverEnabled = state;
+}
+
+bool DataFetcher::isMirrorError(QNetworkReply::NetworkError code) const
+{
+    // Connection and server failures. Missing files are asked
+    // from the main server only, other content errors are final
+    return code < QNetworkReply::ContentAccessDenied
+           || code >= QNetworkReply::InternalServerError;
+}
+
 void DataFetcher::makePost(const QUrl &url, const QByteArray &postData)
 {
     log( tr("Make POST request: %1").arg( url.toString() ) );
@@ -116,10 +169,24 @@ void DataFetcher::makePost(const QUrl &url, const QByteArray &postData)
     request.setHeader( QNetworkRequest::ContentLengthHeader, postData.size() );
 
     reset();
+
+    method = MethodPost;
     reply = nam->post(request, postData);
     handleReply();
 }
 
+void DataFetcher::makePost(const QUrl &url, QHttpMultiPart *multiPart)
+{
+    log( tr("Make multipart POST request: %1").arg( url.toString() ) );
+
+    reset();
+
+    method = MethodPost;
+    reply = nam->post(QNetworkRequest(url), multiPart);
+    multiPart->setParent(reply);
+    handleReply();
+}
+
 bool DataFetcher::isWaiting() const
 {
     return waiting;
@@ -131,12 +198,45 @@ void DataFetcher::onRequestFinished()
 
     if (reply->error() == QNetworkReply::NoError)
     {
-        data = reply->readAll();
+        // Tail of the reply can't be delayed anymore
+        QByteArray tail = reply->readAll();
+        BandwidthLimiter::instance()->charge( tail.size() );
+        data.append(tail);
 
         QNetworkRequest::KnownHeaders cl = QNetworkRequest::ContentLengthHeader;
         size = reply->header(cl).toULongLong();
     }
-    else
+    else if (failoverEnabled && method != MethodPost)
+    {
+        QNetworkReply::NetworkError code = reply->error();
+        QUrl mirrorUrl;
+
+        if ( isMirrorError(code) )
+        {
+            mirrorUrl = MirrorList::instance()->failover(requestUrl);
+        }
+        else if (code == QNetworkReply::ContentNotFoundError)
+        {
+            // New files may have not reached the mirror yet
+            mirrorUrl = MirrorList::instance()->getMainServerUrl(requestUrl);
+        }
+
+        if ( mirrorUrl.isValid() )
+        {
+            log( tr("Error! %1").arg( reply->errorString() ) );
+            log( tr("Retrying: %1").arg( mirrorUrl.toString() ) );
+
+            // Partial data of the failed reply is dropped
+            unhandleReply();
+            reset();
+
+            requestUrl = mirrorUrl;
+            send();
+            return;
+        }
+    }
+
+    if (reply->error() != QNetworkReply::NoError)
     {
         if (reply->error() == QNetworkReply::AuthenticationRequiredError)
         {
@@ -156,6 +256,28 @@ void DataFetcher::onRequestFinished()
     emit finished(result);
 }
 
+void DataFetcher::onReadyRead()
+{
+    if (!waiting)
+    {
+        return;
+    }
+
+    qint64 available = reply->bytesAvailable();
+    qint64 allowed = BandwidthLimiter::instance()->take(available);
+
+    if (allowed > 0)
+    {
+        data.append( reply->read(allowed) );
+    }
+
+    // Full buffer stops the connection until the rest is read
+    if ( reply->bytesAvailable() > 0 )
+    {
+        throttleTimer->start();
+    }
+}
+
 void DataFetcher::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
     stopTimer();
@@ -17,8 +17,14 @@ public:
     void makeGet(const QUrl &url);
     void makePost(const QUrl &url, const QByteArray &postData);
 
+    // Multipart form is streamed from its parts and owned by the reply
+    void makePost(const QUrl &url, QHttpMultiPart *multiPart);
+
     bool isWaiting() const;
 
+    // Failed GET and HEAD requests are repeated on other mirrors
+    void setFailoverEnabled(bool state);
+
     const QByteArray &getData() const;
     quint64 getSize();
     const QString &errorString() const;
@@ -27,9 +33,20 @@ private:
     QNetworkAccessManager *nam;
     QNetworkReply *reply;
     QTimer *timer;
+    QTimer *throttleTimer;
+
+    // Limited read buffer lets the limiter hold the connection back
+    static const int readBufferSize = 256 * 1024;
+    static const int throttleInterval = 50;
 
     bool waiting;
 
+    // Last request, kept to repeat it on another mirror
+    enum Method { MethodHead, MethodGet, MethodPost };
+    Method method;
+    QUrl requestUrl;
+    bool failoverEnabled;
+
     QByteArray data;
     QString error;
     quint64 size;
@@ -41,6 +58,9 @@ private:
     void handleReply();
     void unhandleReply();
 
+    bool isMirrorError(QNetworkReply::NetworkError code) const;
+    void send();
+
 signals:
     void progress(qint64 bytesReceived, qint64 bytesTotal);
     void finished(bool result);
@@ -53,6 +73,7 @@ private slots:
     void stopTimer();
 
     void onRequestFinished();
+    void onReadyRead();
     void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 };
 
@@ -0,0 +1,86 @@
+#include "diagnosticsbundle.h"
+#include "crashwatcher.h"
+
+DiagnosticsBundle::DiagnosticsBundle(const QString &fileName) :
+    gzip(fileName)
+{
+    failed = false;
+}
+
+bool DiagnosticsBundle::open()
+{
+    failed = !gzip.open(QIODevice::WriteOnly);
+    return !failed;
+}
+
+bool DiagnosticsBundle::close()
+{
+    gzip.close();
+    return !failed;
+}
+
+bool DiagnosticsBundle::hasErrors() const
+{
+    return failed;
+}
+
+QString DiagnosticsBundle::errorString() const
+{
+    return gzip.errorString();
+}
+
+void DiagnosticsBundle::write(const QByteArray &data)
+{
+    if ( !failed && gzip.write(data) != data.size() )
+    {
+        failed = true;
+    }
+}
+
+void DiagnosticsBundle::addSection(const QString &title)
+{
+    write( QString("[%1]\n\n").arg(title).toUtf8() );
+}
+
+void DiagnosticsBundle::addText(const QString &text)
+{
+    write( text.toUtf8() );
+    write("\n");
+}
+
+void DiagnosticsBundle::addFile(const QString &path)
+{
+    QString name = QFileInfo(path).fileName();
+    write( QString("File '%1':\n").arg(name).toUtf8() );
+
+    QFile file(path);
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        write( QString("Can't read: %1\n\n").arg( file.errorString() )
+               .toUtf8() );
+        return;
+    }
+
+    while ( !file.atEnd() && !failed )
+    {
+        write( file.read(chunkSize) );
+    }
+
+    file.close();
+    write("\n");
+}
+
+void DiagnosticsBundle::addCrashReports(const QString &prefix, int maxCount)
+{
+    QStringList reports = CrashWatcher::findReports(prefix);
+    if ( reports.isEmpty() )
+    {
+        addText("No crash reports.\n");
+        return;
+    }
+
+    foreach ( QString path, reports.mid(0, maxCount) )
+    {
+        addFile(path);
+    }
+}
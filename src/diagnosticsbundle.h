@@ -0,0 +1,37 @@
+#ifndef DIAGNOSTICSBUNDLE_H
+#define DIAGNOSTICSBUNDLE_H
+
+#include <QtCore>
+
+#include <quazip5/quagzipfile.h>
+
+// Gzipped diagnostic log written section by section,
+// files are streamed into it without loading them into memory
+class DiagnosticsBundle
+{
+public:
+    explicit DiagnosticsBundle(const QString &fileName);
+
+    bool open();
+    bool close();
+
+    void addSection(const QString &title);
+    void addText(const QString &text);
+    void addFile(const QString &path);
+
+    // Reports found in client prefix, newest first
+    void addCrashReports(const QString &prefix, int maxCount);
+
+    bool hasErrors() const;
+    QString errorString() const;
+
+private:
+    static const int chunkSize = 64 * 1024;
+
+    QuaGzipFile gzip;
+    bool failed;
+
+    void write(const QByteArray &data);
+};
+
+#endif // DIAGNOSTICSBUNDLE_H
@@ -2,8 +2,9 @@
 #include "../ui/ui_feedbackdialog.h"
 
 #include "settings.h"
-#include "util.h"
 #include "jsonparser.h"
+#include "javaregistry.h"
+#include "diagnosticsbundle.h"
 
 #include <QMessageBox>
 
@@ -16,6 +17,8 @@ FeedbackDialog::FeedbackDialog(QWidget *parent) :
     logger = Logger::logger();
     Settings *settings = Settings::instance();
 
+    multipartSent = false;
+
     ui->nickEdit->setText( settings->loadLogin() );
 
     if ( settings->loadPassStoreState() )
@@ -53,12 +56,6 @@ void FeedbackDialog::sendFeedback()
     QString brief = ui->descEdit->toPlainText();
     log( tr("Brief:\n%1").arg(brief) );
 
-    QJsonObject payload;
-    payload["username"] = ui->nickEdit->text();
-    payload["password"] = ui->passEdit->text();
-
-    payload["desc"] = "GZIP DATA";
-
     if ( ui->nickEdit->text().isEmpty() )
     {
         msg( tr("Error! Nickname does not set!") );
@@ -75,75 +72,189 @@ void FeedbackDialog::sendFeedback()
 
     Settings *settings = Settings::instance();
 
-    QByteArray diag;
-    diag.append("[General]\n");
-    diag.append("\n");
+    // Logs are compressed on the fly instead of being read in memory
+    QString logsPrefix = settings->getBaseDir() + "/";
+    bundlePath = logsPrefix + "diagnostics.log.gz";
 
-    diag.append(settings->getOsName() + ", ");
-    diag.append(settings->getOsVersion() + ", ");
-    diag.append("arch: " + settings->getWordSize() + ".\n");
-    diag.append("\n");
+    DiagnosticsBundle bundle(bundlePath);
+    if ( !bundle.open() )
+    {
+        msg( tr("Error! %1").arg( bundle.errorString() ) );
+        ui->sendButton->setEnabled(true);
+        return;
+    }
 
-    diag.append("[Description]\n");
-    diag.append("\n");
+    bundle.addSection("General");
+    bundle.addText( settings->getOsName() + ", "
+                    + settings->getOsVersion() + ", "
+                    + "arch: " + settings->getWordSize() + ".\n" );
 
-    diag.append(brief + "\n");
-    diag.append("\n");
+    bundle.addSection("Description");
+    bundle.addText(brief + "\n");
 
-    diag.append("[Java]\n");
-    diag.append("\n");
+    // Runtimes are described from the registry cache,
+    // a hung Java must not freeze the dialog
+    JavaRegistry *registry = JavaRegistry::instance();
 
-    diag.append( Util::getCommandOutput("java", QStringList() << "-version") );
-    diag.append("\n");
+    bundle.addSection("Java");
+    bundle.addText( registry->describe() );
 
-    diag.append("[Logs]\n");
-    diag.append("\n");
+    if ( settings->loadClientJavaState() )
+    {
+        QString java = settings->loadClientJava();
+        JavaRuntime runtime;
+
+        if ( registry->findRuntime(java, &runtime) )
+        {
+            bundle.addText( QString("Custom Java: %1, %2, %3\n")
+                            .arg(java, runtime.version, runtime.vendor) );
+        }
+        else
+        {
+            bundle.addText( QString("Custom Java: %1, not probed\n")
+                            .arg(java) );
+        }
+    }
 
-    QString logsPrefix = settings->getBaseDir() + "/";
+    bundle.addSection("Logs");
     for (int i = 0; i < 3; i++)
     {
-        QString file = QString("launcher.%1.log").arg(i);
-        diag.append( QString("Log file '%1':\n").arg(file) );
-        diag.append( Util::getFileContetnts(logsPrefix + file) );
-        diag.append("\n");
+        bundle.addFile( logsPrefix + QString("launcher.%1.log").arg(i) );
     }
+    bundle.addFile(logsPrefix + "game.0.log");
 
-    // Gzip and base-64 encode log
-    QByteArray zlog = Util::makeGzip(diag);
-    payload["log"] = QString( zlog.toBase64() );
+    QString version = settings->loadClientVersion();
+    bundle.addSection("Crash reports");
+    bundle.addCrashReports(settings->getClientPrefix(version),
+                           maxCrashReports);
 
-    QJsonDocument jsonRequest(payload);
+    if ( !bundle.close() )
+    {
+        msg( tr("Error! %1").arg( bundle.errorString() ) );
+        ui->sendButton->setEnabled(true);
+        return;
+    }
+
+    // Multipart upload is used only with servers known to accept it
+    if ( settings->loadFeedbackMultipartState() && sendMultipart() )
+    {
+        return;
+    }
+
+    sendJson();
+}
+
+bool FeedbackDialog::sendMultipart()
+{
+    // Log is sent as a file part, read from disk while uploading
+    QHttpMultiPart::ContentType formData = QHttpMultiPart::FormDataType;
+    QHttpMultiPart *multiPart = new QHttpMultiPart(formData);
+
+    multiPart->append( makeFormPart( "username", ui->nickEdit->text() ) );
+    multiPart->append( makeFormPart( "password", ui->passEdit->text() ) );
+    multiPart->append( makeFormPart("desc", "GZIP DATA") );
+
+    QFile *bundleFile = new QFile(bundlePath, multiPart);
+    if ( !bundleFile->open(QIODevice::ReadOnly) )
+    {
+        log( tr("Error! %1").arg( bundleFile->errorString() ) );
+
+        delete multiPart;
+        return false;
+    }
+
+    QHttpPart logPart;
+    logPart.setHeader(QNetworkRequest::ContentTypeHeader, "application/gzip");
+    logPart.setHeader(QNetworkRequest::ContentDispositionHeader,
+        "form-data; name=\"log\"; filename=\"diagnostics.log.gz\"");
+    logPart.setBodyDevice(bundleFile);
+
+    multiPart->append(logPart);
 
     msg( tr("Uploading diagnostic log...") );
-    uploader.makePost( Settings::feedbackUrl, jsonRequest.toJson() );
+
+    multipartSent = true;
+    uploader.makePost(Settings::feedbackUrl, multiPart);
+
+    return true;
 }
 
-void FeedbackDialog::requestFinished(bool result)
+void FeedbackDialog::sendJson()
 {
-    ui->sendButton->setEnabled(true);
+    multipartSent = false;
+
+    QJsonObject payload;
+    payload["username"] = ui->nickEdit->text();
+    payload["password"] = ui->passEdit->text();
 
-    QString error = tr("Error! %1");
+    payload["desc"] = "GZIP DATA";
 
-    if (!result)
+    // Base-64 encode log
+    QFile bundleFile(bundlePath);
+    if ( !bundleFile.open(QIODevice::ReadOnly) )
     {
-        msg( error.arg( uploader.errorString() ) );
+        msg( tr("Error! %1").arg( bundleFile.errorString() ) );
+        ui->sendButton->setEnabled(true);
         return;
     }
 
+    payload["log"] = QString( bundleFile.readAll().toBase64() );
+    bundleFile.close();
+
+    QJsonDocument jsonRequest(payload);
+
+    msg( tr("Uploading diagnostic log...") );
+    uploader.makePost( Settings::feedbackUrl, jsonRequest.toJson() );
+}
+
+QHttpPart FeedbackDialog::makeFormPart(const QString &name,
+                                       const QString &value)
+{
+    QHttpPart part;
+    part.setHeader( QNetworkRequest::ContentDispositionHeader,
+                    QString("form-data; name=\"%1\"").arg(name) );
+    part.setBody( value.toUtf8() );
+
+    return part;
+}
+
+void FeedbackDialog::requestFinished(bool result)
+{
+    QString error;
     JsonParser parser;
 
-    if ( !parser.setJson( uploader.getData() ) )
+    if (!result)
     {
-        msg( error.arg( parser.getParserError() ) );
-        return;
+        error = uploader.errorString();
+    }
+    else if ( !parser.setJson( uploader.getData() ) )
+    {
+        error = parser.getParserError();
+    }
+    else if ( parser.hasServerResponseError() )
+    {
+        error = parser.getServerResponseError();
     }
 
-    if ( parser.hasServerResponseError() )
+    if ( !error.isEmpty() )
     {
-        msg( error.arg( parser.getServerResponseError() ) );
+        // Server may not accept multipart forms, try the old way
+        if (multipartSent)
+        {
+            log( tr("Error! %1").arg(error) );
+            log( tr("Multipart upload failed, sending log as JSON...") );
+
+            sendJson();
+            return;
+        }
+
+        msg( tr("Error! %1").arg(error) );
+        ui->sendButton->setEnabled(true);
         return;
     }
 
+    ui->sendButton->setEnabled(true);
+
     QString title = tr("Complete!");
     QString message = tr("Feedback log successfully uploaded!");
 
@@ -2,6 +2,7 @@
 #define FEEDBACKDIALOG_H
 
 #include <QDialog>
+#include <QHttpMultiPart>
 
 #include "logger.h"
 #include "datafetcher.h"
@@ -19,14 +20,24 @@ public:
     ~FeedbackDialog();
 
 private:
+    static const int maxCrashReports = 3;
+
     Ui::FeedbackDialog *ui;
     Logger* logger;
 
     DataFetcher uploader;
 
+    QString bundlePath;
+    bool multipartSent;
+
     void log(const QString &text);
     void msg(const QString &text);
 
+    bool sendMultipart();
+    void sendJson();
+
+    static QHttpPart makeFormPart(const QString &name, const QString &value);
+
 private slots:
     void sendFeedback();
     void requestFinished(bool result);
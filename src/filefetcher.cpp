@@ -31,11 +31,13 @@ void FileFetcher::log(const QString &text)
 void FileFetcher::add(QUrl url, QString filename)
 {
     fetchData.append( QPair<QUrl, QString >(url, filename) );
+    fileSizes.append(0);
 }
 
 void FileFetcher::add(QUrl url, QString filename, quint64 size)
 {
     add(url, filename);
+    fileSizes.last() = size;
     fetchSize += size;
 }
 
@@ -50,6 +52,7 @@ void FileFetcher::reset()
     fetchSize = 0;
 
     fetchData.clear();
+    fileSizes.clear();
 
     hasFetchErrors = false;
 }
@@ -57,6 +60,7 @@ void FileFetcher::reset()
 void FileFetcher::cancel()
 {
     df.cancel();
+    segmented.cancel();
 
     if (fetchingSizes)
     {
@@ -74,6 +78,12 @@ void FileFetcher::cancel()
         disconnect(&df, &DataFetcher::progress,
                    this, &FileFetcher::fileFetchProgress);
 
+        disconnect(&segmented, &SegmentedDownload::finished,
+                   this, &FileFetcher::segmentedFetched);
+
+        disconnect(&segmented, &SegmentedDownload::progress,
+                   this, &FileFetcher::fileFetchProgress);
+
         fetchingFiles = false;
     }
 }
@@ -121,6 +131,7 @@ void FileFetcher::sizeFetched(bool result)
 {
     if (result)
     {
+        fileSizes[current] = df.getSize();
         fetchSize += df.getSize();
 
         float percents = ( float(current + 1) / fetchData.count() ) * 100;
@@ -184,6 +195,12 @@ void FileFetcher::fetchFiles()
         connect(&df, &DataFetcher::progress,
                 this, &FileFetcher::fileFetchProgress);
 
+        connect(&segmented, &SegmentedDownload::finished,
+                this, &FileFetcher::segmentedFetched);
+
+        connect(&segmented, &SegmentedDownload::progress,
+                this, &FileFetcher::fileFetchProgress);
+
         fetchingFiles = true;
 
         hasFetchErrors = false;
@@ -208,7 +225,15 @@ void FileFetcher::fetchCurrentFile()
 
     emit filesFetchNewTarget(url.toString(), fname);
 
-    df.makeGet(url);
+    qint64 size = fileSizes[current];
+    if (size >= SegmentedDownload::threshold)
+    {
+        segmented.start(url, fname, size);
+    }
+    else
+    {
+        df.makeGet(url);
+    }
 }
 
 void FileFetcher::fileFetchProgress(qint64 bytesReceived, qint64 bytesTotal)
@@ -228,40 +253,80 @@ void FileFetcher::fileFetchProgress(qint64 bytesReceived, qint64 bytesTotal)
 
 void FileFetcher::fileFetched(bool result)
 {
-    QString fname = fetchData[current].second;
-
     if (result)
     {
-        QFile file(fname);
-        QDir fdir = QFileInfo(fname).absoluteDir();
-        fdir.mkpath( fdir.absolutePath() );
+        saveFile(fetchData[current].second);
+    }
+    else
+    {
+        hasFetchErrors = true;
+        emit filesFetchError( df.errorString() );
+    }
+
+    fetchNextFile();
+}
+
+void FileFetcher::saveFile(const QString &fname)
+{
+    QFile file(fname);
+    QDir fdir = QFileInfo(fname).absoluteDir();
+    fdir.mkpath( fdir.absolutePath() );
+
+    // File may be hard-linked from a local store, so never write
+    // through it, replace it instead
+    QFile::remove(fname);
+
+    if ( !file.open(QIODevice::WriteOnly) )
+    {
+        hasFetchErrors = true;
+
+        log( tr("Error! %1").arg( file.errorString() ) );
+        emit filesFetchError( file.errorString() );
+        return;
+    }
 
-        if ( !file.open(QIODevice::WriteOnly) )
-        {
-            hasFetchErrors = true;
+    file.write( df.getData() );
+    file.close();
 
-            log( tr("Error! %1").arg( file.errorString() ) );
-            emit filesFetchError( file.errorString() );
-        }
-        else
-        {
-            file.write( df.getData() );
-            file.close();
+    fetched += file.size();
+
+    QString shortName = fname.mid(hiddenLenght);
+    log( tr("File saved: %1").arg(shortName) );
+
+    emit filesFetchProgress( int(float(fetched) / fetchSize * 100) );
+}
+
+void FileFetcher::segmentedFetched(bool result)
+{
+    QString fname = fetchData[current].second;
 
-            fetched += file.size();
+    if (result)
+    {
+        fetched += fileSizes[current];
 
-            QString shortName = fname.mid(hiddenLenght);
-            log( tr("File saved: %1").arg(shortName) );
+        QString shortName = fname.mid(hiddenLenght);
+        log( tr("File saved: %1").arg(shortName) );
 
-            emit filesFetchProgress( int(float(fetched) / fetchSize * 100) );
-        }
+        emit filesFetchProgress( int(float(fetched) / fetchSize * 100) );
+    }
+    else if ( segmented.isRangeUnsupported() )
+    {
+        // Fetched whole, the file is saved by fileFetched()
+        log( tr("Fetch the file in one piece.") );
+        df.makeGet(fetchData[current].first);
+        return;
     }
     else
     {
         hasFetchErrors = true;
-        emit filesFetchError( df.errorString() );
+        emit filesFetchError( segmented.errorString() );
     }
 
+    fetchNextFile();
+}
+
+void FileFetcher::fetchNextFile()
+{
     current++;
     if ( current < fetchData.count() )
     {
@@ -278,6 +343,12 @@ void FileFetcher::fileFetched(bool result)
         disconnect(&df, &DataFetcher::progress,
                    this, &FileFetcher::fileFetchProgress);
 
+        disconnect(&segmented, &SegmentedDownload::finished,
+                   this, &FileFetcher::segmentedFetched);
+
+        disconnect(&segmented, &SegmentedDownload::progress,
+                   this, &FileFetcher::fileFetchProgress);
+
         fetchingFiles = false;
 
         emit filesFetchFinished();
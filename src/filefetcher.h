@@ -6,6 +6,7 @@
 
 #include "logger.h"
 #include "datafetcher.h"
+#include "segmenteddownload.h"
 
 class FileFetcher : public QObject
 {
@@ -34,9 +35,13 @@ private:
     quint64 fetchSize;
 
     QList< QPair<QUrl, QString> > fetchData;
+    QList<quint64> fileSizes;
     int current;
 
     DataFetcher df;
+
+    // Large files of known size go over several connections
+    SegmentedDownload segmented;
     bool hasFetchErrors;
 
     Logger *logger;
@@ -47,6 +52,9 @@ private:
     bool fetchingSizes;
     bool fetchingFiles;
 
+    void saveFile(const QString &fname);
+    void fetchNextFile();
+
 signals:
     void sizesFetchProgress(int progress);
     void sizesFetchError(QString errorString);
@@ -65,6 +73,7 @@ private slots:
 
     void fetchCurrentFile();
     void fileFetched(bool result);
+    void segmentedFetched(bool result);
     void fileFetchProgress(qint64 bytesReceived, qint64 bytesTotal);
 };
 
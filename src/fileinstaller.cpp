@@ -1,40 +1,158 @@
 #include "fileinstaller.h"
 #include "hashchecker.h"
+#include "installmanifest.h"
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#endif
+
+// Processes one part of the install list in the installer's thread pool
+class InstallTask : public QRunnable
+{
+public:
+    InstallTask(FileInstaller *fileInstaller, const QList<InstallInfo> &list)
+    {
+        installer = fileInstaller;
+        shard = list;
+    }
+
+    void run()
+    {
+        installer->processShard(shard);
+    }
+
+private:
+    FileInstaller *installer;
+    QList<InstallInfo> shard;
+};
 
 FileInstaller::FileInstaller()
 {
     qRegisterMetaType<QList<InstallInfo> >("QList<InstallInfo>");
+
+    total = 0;
+    copyMode = CopyAuto;
+
+    pool.setMaxThreadCount( QThread::idealThreadCount() );
+
+    // Manifest is shared by the pool workers, so it has to be created
+    // here, in the GUI thread, before any of them could create their own
+    InstallManifest::instance();
 }
 
 void FileInstaller::doInstall(const QList<InstallInfo> &list)
 {
-    cancelled = false;
+    cancelled.store(0);
+    processed.store(0);
+    lastPercents.store(0);
+
+    createdDirs.clear();
 
-    int total = list.count();
-    int current = 0;
+    // Different assets may refer to the same object file, so skip duplicates
+    // to prevent concurrent writes to one destination
+    QSet<QString> destinations;
+    QList<InstallInfo> uniqueList;
 
     foreach (const InstallInfo entry, list)
     {
-        if (cancelled)
+        if ( !destinations.contains(entry.path) )
+        {
+            destinations.insert(entry.path);
+            uniqueList.append(entry);
+        }
+    }
+
+    total = uniqueList.count();
+
+    // Interleave entries between shards to mix large and small files
+    int shardsCount = qMax(1, pool.maxThreadCount());
+    QVector< QList<InstallInfo> > shards(shardsCount);
+
+    for (int i = 0; i < total; i++)
+    {
+        shards[i % shardsCount].append( uniqueList.at(i) );
+    }
+
+    foreach (const QList<InstallInfo> &shard, shards)
+    {
+        if ( !shard.isEmpty() )
+        {
+            pool.start( new InstallTask(this, shard) );
+        }
+    }
+
+    pool.waitForDone();
+
+    InstallManifest::instance()->save();
+
+    if ( cancelled.load() )
+    {
+        return;
+    }
+
+    emit finished();
+}
+
+void FileInstaller::processShard(const QList<InstallInfo> &shard)
+{
+    foreach (const InstallInfo entry, shard)
+    {
+        if ( cancelled.load() )
         {
             return;
         }
 
         processFile(entry);
+        fileProcessed();
+    }
+}
 
-        current++;
-        emit progress( int(float(current) / total * 100) );
+void FileInstaller::fileProcessed()
+{
+    int current = processed.fetchAndAddOrdered(1) + 1;
+    int percents = int(float(current) / total * 100);
+
+    // Emit progress only once for each percent from all workers
+    int last = lastPercents.load();
+    if ( percents > last && lastPercents.testAndSetOrdered(last, percents) )
+    {
+        emit progress(percents);
     }
+}
 
-    emit finished();
+void FileInstaller::makeParentDir(const QString &path)
+{
+    QString dirPath = QFileInfo(path).absolutePath();
+
+    QMutexLocker locker(&dirsMutex);
+    if ( createdDirs.contains(dirPath) )
+    {
+        return;
+    }
+
+    QDir().mkpath(dirPath);
+    createdDirs.insert(dirPath);
 }
 
 void FileInstaller::processFile(const InstallInfo &info)
 {
+    InstallManifest *manifest = InstallManifest::instance();
     bool fileExists = QFile::exists(info.path);
 
     if (info.action == InstallInfo::Delete)
     {
+        manifest->remove(info.path);
+
         if ( fileExists && !QFile::remove(info.path) )
         {
             emit installFailed(info);
@@ -42,6 +160,8 @@ void FileInstaller::processFile(const InstallInfo &info)
     }
     else if (info.action == InstallInfo::Update)
     {
+        bool immutable = isImmutable(info);
+
         if (fileExists)
         {
             if ( info.hash.isEmpty() )
@@ -49,29 +169,222 @@ void FileInstaller::processFile(const InstallInfo &info)
                 return;
             }
 
-            if ( HashChecker::isFileHashValid(info.path, info.hash) )
+            // Trust the store hash while file metadata is unchanged
+            if ( immutable && manifest->isFileValid(info.path, info.hash) )
             {
                 return;
             }
 
+            if ( immutable
+                 && HashChecker::isFileHashValid(info.path, info.hash) )
+            {
+                manifest->update(info.path, info.hash);
+                return;
+            }
+
             // Delete exists file before copy
             QFile::remove(info.path);
         }
 
-        QDir dir = QFileInfo(info.path).absoluteDir();
-        if ( !dir.exists() )
+        makeParentDir(info.path);
+
+        if ( !copyFile(info) )
         {
-            dir.mkpath( dir.absolutePath() );
+            manifest->remove(info.path);
+            emit installFailed(info);
         }
+        else if (immutable)
+        {
+            manifest->update(info.path, info.hash);
+        }
+    }
+}
 
-        if ( !QFile::copy(info.srcPath, info.path) )
+bool FileInstaller::copyFile(const InstallInfo &info) const
+{
+#ifdef Q_OS_LINUX
+    if (copyMode != CopyPlain)
+    {
+        if ( cloneFile(info.srcPath, info.path) )
         {
-            emit installFailed(info);
+            return true;
+        }
+
+        // Linked files share data with the store, so only files which
+        // are never changed in place are allowed
+        if ( copyMode == CopyAuto && isImmutable(info)
+             && linkFile(info.srcPath, info.path) )
+        {
+            return true;
+        }
+
+        if ( copyFileRange(info.srcPath, info.path) )
+        {
+            return true;
         }
     }
+#endif
+
+    return QFile::copy(info.srcPath, info.path);
+}
+
+bool FileInstaller::isImmutable(const InstallInfo &info)
+{
+    // Empty hash marks mutable files, "0" marks indexes to be always replaced
+    return !info.hash.isEmpty() && info.hash != "0";
+}
+
+#ifdef Q_OS_LINUX
+bool FileInstaller::cloneFile(const QString &srcPath, const QString &path)
+{
+    QByteArray srcName = QFile::encodeName(srcPath);
+    QByteArray name = QFile::encodeName(path);
+
+    int src = ::open(srcName.constData(), O_RDONLY | O_CLOEXEC);
+    if (src < 0)
+    {
+        return false;
+    }
+
+    struct stat srcStat;
+    if (::fstat(src, &srcStat) != 0)
+    {
+        ::close(src);
+        return false;
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    int dst = ::open(name.constData(), flags, srcStat.st_mode & 0777);
+    if (dst < 0)
+    {
+        ::close(src);
+        return false;
+    }
+
+    bool cloned = ::ioctl(dst, FICLONE, src) == 0;
+
+    ::close(dst);
+    ::close(src);
+
+    if (!cloned)
+    {
+        ::unlink( name.constData() );
+    }
+
+    return cloned;
+}
+
+bool FileInstaller::linkFile(const QString &srcPath, const QString &path)
+{
+    QByteArray srcName = QFile::encodeName(srcPath);
+    QByteArray name = QFile::encodeName(path);
+
+    return ::link( srcName.constData(), name.constData() ) == 0;
+}
+
+bool FileInstaller::copyFileRange(const QString &srcPath, const QString &path)
+{
+    QByteArray srcName = QFile::encodeName(srcPath);
+    QByteArray name = QFile::encodeName(path);
+
+    int src = ::open(srcName.constData(), O_RDONLY | O_CLOEXEC);
+    if (src < 0)
+    {
+        return false;
+    }
+
+    struct stat srcStat;
+    if (::fstat(src, &srcStat) != 0)
+    {
+        ::close(src);
+        return false;
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    int dst = ::open(name.constData(), flags, srcStat.st_mode & 0777);
+    if (dst < 0)
+    {
+        ::close(src);
+        return false;
+    }
+
+    off_t left = srcStat.st_size;
+    bool useSendfile = false;
+
+#ifdef SYS_copy_file_range
+    // Data stays in the kernel and may be offloaded to the filesystem
+    while (left > 0)
+    {
+        ssize_t copied = ::syscall(SYS_copy_file_range, src, NULL,
+                                   dst, NULL, size_t(left), 0u);
+        if (copied <= 0)
+        {
+            // Not supported here, retry from the beginning with sendfile
+            bool untouched = left == srcStat.st_size;
+            if ( copied < 0 && untouched
+                 && (errno == ENOSYS || errno == EXDEV
+                     || errno == EINVAL || errno == EOPNOTSUPP) )
+            {
+                useSendfile = true;
+            }
+            break;
+        }
+        left -= copied;
+    }
+#else
+    useSendfile = true;
+#endif
+
+    if (useSendfile)
+    {
+        while (left > 0)
+        {
+            ssize_t copied = ::sendfile(dst, src, NULL, size_t(left));
+            if (copied <= 0)
+            {
+                break;
+            }
+            left -= copied;
+        }
+    }
+
+    bool result = left == 0 && ::close(dst) == 0;
+    if (left != 0)
+    {
+        ::close(dst);
+    }
+    ::close(src);
+
+    if (!result)
+    {
+        ::unlink( name.constData() );
+    }
+
+    return result;
+}
+#else
+bool FileInstaller::cloneFile(const QString &, const QString &)
+{
+    return false;
+}
+
+bool FileInstaller::linkFile(const QString &, const QString &)
+{
+    return false;
+}
+
+bool FileInstaller::copyFileRange(const QString &, const QString &)
+{
+    return false;
+}
+#endif
+
+void FileInstaller::setCopyMode(CopyMode mode)
+{
+    copyMode = mode;
 }
 
 void FileInstaller::cancel()
 {
-    cancelled = true;
+    cancelled.store(1);
 }
@@ -12,13 +12,42 @@ public:
     FileInstaller();
     void cancel();
 
+    // Copy strategies, faster ones are tried first:
+    // reflink, hardlink (immutable files only), in-kernel copy, plain copy
+    enum CopyMode { CopyAuto, CopyNoLinks, CopyPlain };
+    void setCopyMode(CopyMode mode);
+
 public slots:
     void doInstall(const QList< InstallInfo > &list);
 
 private:
-    bool cancelled;
+    QThreadPool pool;
+
+    QAtomicInt cancelled;
+    QAtomicInt processed;
+    QAtomicInt lastPercents;
+    int total;
+
+    CopyMode copyMode;
+
+    // Directories already created during current installation
+    QMutex dirsMutex;
+    QSet<QString> createdDirs;
+
+    void processShard(const QList<InstallInfo> &shard);
     void processFile(const InstallInfo &info);
 
+    void makeParentDir(const QString &path);
+    bool copyFile(const InstallInfo &info) const;
+
+    static bool isImmutable(const InstallInfo &info);
+    static bool cloneFile(const QString &srcPath, const QString &path);
+    static bool linkFile(const QString &srcPath, const QString &path);
+    static bool copyFileRange(const QString &srcPath, const QString &path);
+    void fileProcessed();
+
+    friend class InstallTask;
+
 signals:
     void progress(int percents);
     void installFailed(const InstallInfo &installInfo);
@@ -0,0 +1,167 @@
+#include "gamelog.h"
+#include "logger.h"
+
+GameLog::GameLog(const QString &logDir, QObject *parent) : QObject(parent)
+{
+    this->logDir = logDir;
+
+    minimalLevel = LevelInfo;
+    lastLevel = LevelInfo;
+    forwardGcLines = false;
+}
+
+void GameLog::setMinimalLevel(int level)
+{
+    minimalLevel = Level(level);
+}
+
+void GameLog::setForwardGcLines(bool state)
+{
+    forwardGcLines = state;
+}
+
+void GameLog::openLogFile()
+{
+    // Rotate logs like the launcher does
+    QString last = QString::number(logRotations - 1);
+    QFile::remove(logDir + "/game." + last + ".log");
+
+    for (int i = logRotations - 2; i >= 0; i--)
+    {
+        QString cur = QString::number(i);
+        QString nxt = QString::number(i + 1);
+
+        QFile::rename(logDir + "/game." + cur + ".log",
+                      logDir + "/game." + nxt + ".log");
+    }
+
+    logFile.setFileName(logDir + "/game.0.log");
+    if ( !logFile.open(QIODevice::WriteOnly) )
+    {
+        Logger::logger()->appendLine( tr("GameLog"),
+            tr("Can't open game log! %1").arg( logFile.errorString() ) );
+    }
+}
+
+void GameLog::feed(const QByteArray &output)
+{
+    if ( !logFile.isOpen() )
+    {
+        openLogFile();
+    }
+
+    // Raw output is kept as is, file buffer takes care of small writes
+    logFile.write(output);
+
+    pending.append(output);
+
+    int start = 0;
+    forever
+    {
+        int end = pending.indexOf('\n', start);
+        if (end == -1)
+        {
+            break;
+        }
+
+        handleLine( pending.mid(start, end - start) );
+        start = end + 1;
+    }
+
+    pending.remove(0, start);
+
+    if (pending.size() > maxLineLength)
+    {
+        handleLine(pending);
+        pending.clear();
+    }
+}
+
+void GameLog::finish()
+{
+    if ( !pending.isEmpty() )
+    {
+        handleLine(pending);
+        pending.clear();
+    }
+
+    logFile.close();
+}
+
+void GameLog::handleLine(const QByteArray &rawLine)
+{
+    QString line = QString::fromLocal8Bit(rawLine);
+    if ( line.endsWith('\r') )
+    {
+        line.chop(1);
+    }
+
+    if ( line.trimmed().isEmpty() )
+    {
+        return;
+    }
+
+    if ( forwardGcLines && line.startsWith('[') && line.contains("][gc") )
+    {
+        emit gcLine(line);
+    }
+
+    // Stack traces and other continuation lines inherit the last level
+    Record record;
+    if ( parseRecord(line, &record) )
+    {
+        lastLevel = record.level;
+    }
+
+    if (lastLevel >= minimalLevel)
+    {
+        Logger::logger()->appendLine(tr("Game"), line);
+    }
+}
+
+bool GameLog::parseRecord(const QString &line, Record *record)
+{
+    static QRegularExpression pattern(
+        "^\\[([0-9:.]+)\\] \\[([^\\]]+)/([A-Z]+)\\]"
+        "(?: \\[([^\\]]+)\\])?: (.*)$" );
+
+    QRegularExpressionMatch match = pattern.match(line);
+    if ( !match.hasMatch() )
+    {
+        return false;
+    }
+
+    record->time = match.captured(1);
+    record->thread = match.captured(2);
+    record->level = parseLevel( match.captured(3) );
+    record->logger = match.captured(4);
+    record->message = match.captured(5);
+
+    return true;
+}
+
+GameLog::Level GameLog::parseLevel(const QString &name)
+{
+    if (name == "TRACE")
+    {
+        return LevelTrace;
+    }
+    else if (name == "DEBUG")
+    {
+        return LevelDebug;
+    }
+    else if (name == "WARN")
+    {
+        return LevelWarn;
+    }
+    else if (name == "ERROR")
+    {
+        return LevelError;
+    }
+    else if (name == "FATAL")
+    {
+        return LevelFatal;
+    }
+
+    return LevelInfo;
+}
@@ -0,0 +1,69 @@
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+#include <QtCore>
+
+// Splits game output into lines and parses Log4j console records.
+// Works in its own thread: raw output goes to rotating game logs,
+// only records of the wanted level are passed to the launcher log
+class GameLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Level
+    {
+        LevelTrace,
+        LevelDebug,
+        LevelInfo,
+        LevelWarn,
+        LevelError,
+        LevelFatal
+    };
+
+    struct Record
+    {
+        QString time;
+        QString thread;
+        Level level;
+        QString logger;
+        QString message;
+    };
+
+    explicit GameLog(const QString &logDir, QObject *parent = 0);
+
+    // Parses lines like "[12:34:56] [Render thread/INFO] [FML]: text"
+    static bool parseRecord(const QString &line, Record *record);
+    static Level parseLevel(const QString &name);
+
+public slots:
+    void setMinimalLevel(int level);
+    void setForwardGcLines(bool state);
+
+    void feed(const QByteArray &output);
+    void finish();
+
+signals:
+    // Unified JVM logging lines, such as -Xlog:gc output
+    void gcLine(const QString &line);
+
+private:
+    static const int logRotations = 3;
+
+    // Longer lines are split, so the buffer stays bounded
+    static const int maxLineLength = 16 * 1024;
+
+    QString logDir;
+    QFile logFile;
+
+    QByteArray pending;
+
+    Level minimalLevel;
+    Level lastLevel;
+    bool forwardGcLines;
+
+    void openLogFile();
+    void handleLine(const QByteArray &rawLine);
+};
+
+#endif // GAMELOG_H
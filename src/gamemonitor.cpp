@@ -0,0 +1,288 @@
+#include "gamemonitor.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+GameMonitor::GameMonitor(QObject *parent) : QObject(parent)
+{
+    processId = 0;
+
+    cpuLoad = 0;
+    rss = 0;
+    threads = 0;
+    readBytes = 0;
+    writtenBytes = 0;
+
+    sampleCount = 0;
+    cpuLoadSum = 0;
+    cpuLoadPeak = 0;
+    rssPeak = 0;
+    threadsPeak = 0;
+
+    lastCpuTicks = 0;
+
+    gcCount = 0;
+    gcPauseSum = 0;
+    gcPauseMax = 0;
+    heapAfterGc = 0;
+
+    // "[1.234s][info][gc] GC(7) Pause Young (Normal) (G1 Evacuation Pause)
+    // 120M->40M(256M) 3.456ms"
+    gcPattern.setPattern("\\[gc\\s*\\]\\s+GC\\(\\d+\\)\\s+Pause.*"
+                         "->(\\d+)([KMG])\\(\\d+[KMG]\\)\\s+([\\d.,]+)ms");
+
+    timer.setInterval(sampleInterval);
+    connect(&timer, &QTimer::timeout, this, &GameMonitor::sample);
+}
+
+void GameMonitor::start(qint64 pid)
+{
+    processId = pid;
+
+    sessionTimer.start();
+    sampleTimer.start();
+
+    readCpuTicks(processId, &lastCpuTicks);
+    timer.start();
+}
+
+void GameMonitor::stop()
+{
+    timer.stop();
+}
+
+void GameMonitor::sample()
+{
+    qint64 ticks;
+    if ( !readCpuTicks(processId, &ticks) )
+    {
+        // Not supported here or the process is gone
+        timer.stop();
+        return;
+    }
+
+    double elapsed = sampleTimer.restart() / 1000.0;
+    double ticksPerSecond = 100;
+
+#ifdef Q_OS_LINUX
+    ticksPerSecond = sysconf(_SC_CLK_TCK);
+#endif
+
+    if (elapsed > 0)
+    {
+        // 100% is one fully loaded core
+        cpuLoad = (ticks - lastCpuTicks) / ticksPerSecond / elapsed * 100;
+    }
+    lastCpuTicks = ticks;
+
+    readStatus(processId, &rss, &threads);
+    readIo(processId, &readBytes, &writtenBytes);
+
+    sampleCount++;
+    cpuLoadSum += cpuLoad;
+    cpuLoadPeak = qMax(cpuLoadPeak, cpuLoad);
+    rssPeak = qMax(rssPeak, rss);
+    threadsPeak = qMax(threadsPeak, threads);
+
+    emit updated();
+}
+
+bool GameMonitor::parseGcLine(const QString &line)
+{
+    QRegularExpressionMatch match = gcPattern.match(line);
+    if ( !match.hasMatch() )
+    {
+        return false;
+    }
+
+    qint64 heap = match.captured(1).toLongLong();
+    QString unit = match.captured(2);
+
+    if (unit == "K")
+    {
+        heap *= 1024;
+    }
+    else if (unit == "M")
+    {
+        heap *= 1024 * 1024;
+    }
+    else
+    {
+        heap *= 1024 * 1024 * 1024;
+    }
+
+    QString pauseString = match.captured(3);
+    pauseString.replace(',', '.');
+    double pause = pauseString.toDouble();
+
+    gcCount++;
+    gcPauseSum += pause;
+    gcPauseMax = qMax(gcPauseMax, pause);
+    heapAfterGc = heap;
+
+    if ( !timer.isActive() )
+    {
+        emit updated();
+    }
+
+    return true;
+}
+
+QString GameMonitor::describe() const
+{
+    QStringList parts;
+
+    if (sampleCount > 0)
+    {
+        parts << tr("CPU %1%").arg( qRound(cpuLoad) )
+              << tr("RAM %1").arg( formatSize(rss) )
+              << tr("Threads %1").arg(threads)
+              << tr("I/O %1 / %2").arg( formatSize(readBytes) )
+                                  .arg( formatSize(writtenBytes) );
+    }
+
+    if (gcCount > 0)
+    {
+        parts << tr("GC %1, avg %2 ms, heap %3")
+                 .arg(gcCount)
+                 .arg(gcPauseSum / gcCount, 0, 'f', 1)
+                 .arg( formatSize(heapAfterGc) );
+    }
+
+    return parts.join("  ");
+}
+
+QString GameMonitor::summarize() const
+{
+    QStringList lines;
+
+    int seconds = sessionTimer.isValid() ? sessionTimer.elapsed() / 1000 : 0;
+    QTime duration = QTime(0, 0).addSecs(seconds);
+
+    lines << tr("Session: %1").arg( duration.toString("hh:mm:ss") );
+
+    if (sampleCount > 0)
+    {
+        lines << tr("CPU: average %1%, peak %2%")
+                 .arg( qRound(cpuLoadSum / sampleCount) )
+                 .arg( qRound(cpuLoadPeak) );
+        lines << tr("Memory: peak %1").arg( formatSize(rssPeak) );
+        lines << tr("Threads: peak %1").arg(threadsPeak);
+        lines << tr("Disk: read %1, written %2")
+                 .arg( formatSize(readBytes) )
+                 .arg( formatSize(writtenBytes) );
+    }
+
+    if (gcCount > 0)
+    {
+        lines << tr("GC: %1 pauses, total %2 ms, average %3 ms, max %4 ms")
+                 .arg(gcCount)
+                 .arg(gcPauseSum, 0, 'f', 1)
+                 .arg(gcPauseSum / gcCount, 0, 'f', 1)
+                 .arg(gcPauseMax, 0, 'f', 1);
+    }
+
+    return lines.join("\n");
+}
+
+bool GameMonitor::readCpuTicks(qint64 pid, qint64 *ticks)
+{
+    QFile file( QString("/proc/%1/stat").arg(pid) );
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+
+    QByteArray stat = file.readAll();
+    file.close();
+
+    // Process name may contain spaces, fields are counted after it
+    int nameEnd = stat.lastIndexOf(')');
+    if (nameEnd == -1)
+    {
+        return false;
+    }
+
+    QList<QByteArray> fields = stat.mid(nameEnd + 2).split(' ');
+    if (fields.count() < 13)
+    {
+        return false;
+    }
+
+    // utime and stime are 14th and 15th fields of the whole line
+    *ticks = fields[11].toLongLong() + fields[12].toLongLong();
+    return true;
+}
+
+bool GameMonitor::readStatus(qint64 pid, qint64 *rss, int *threads)
+{
+    QFile file( QString("/proc/%1/status").arg(pid) );
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+
+    foreach ( QByteArray line, file.readAll().split('\n') )
+    {
+        QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.count() < 2)
+        {
+            continue;
+        }
+
+        if (fields[0] == "VmRSS:")
+        {
+            *rss = fields[1].toLongLong() * 1024;
+        }
+        else if (fields[0] == "Threads:")
+        {
+            *threads = fields[1].toInt();
+        }
+    }
+
+    file.close();
+    return true;
+}
+
+bool GameMonitor::readIo(qint64 pid, qint64 *readBytes,
+                         qint64 *writtenBytes)
+{
+    QFile file( QString("/proc/%1/io").arg(pid) );
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+
+    foreach ( QByteArray line, file.readAll().split('\n') )
+    {
+        QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.count() < 2)
+        {
+            continue;
+        }
+
+        if (fields[0] == "read_bytes:")
+        {
+            *readBytes = fields[1].toLongLong();
+        }
+        else if (fields[0] == "write_bytes:")
+        {
+            *writtenBytes = fields[1].toLongLong();
+        }
+    }
+
+    file.close();
+    return true;
+}
+
+QString GameMonitor::formatSize(qint64 bytes)
+{
+    if ( bytes >= Q_INT64_C(1024) * 1024 * 1024 )
+    {
+        double gb = bytes / (1024.0 * 1024 * 1024);
+        return tr("%1 GB").arg(gb, 0, 'f', 1);
+    }
+
+    return tr("%1 MB").arg(bytes / (1024 * 1024));
+}
@@ -0,0 +1,74 @@
+#ifndef GAMEMONITOR_H
+#define GAMEMONITOR_H
+
+#include <QtCore>
+
+// Samples resource usage of the running game and collects garbage
+// collector pauses from -Xlog:gc output. Process statistics are read
+// from /proc, so on other systems only GC data is available
+class GameMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GameMonitor(QObject *parent = 0);
+
+    void start(qint64 pid);
+    void stop();
+
+    // Parses a line of game output, returns true for GC log lines
+    bool parseGcLine(const QString &line);
+
+    // Short text for the live panel
+    QString describe() const;
+
+    // Multiline summary of the whole session
+    QString summarize() const;
+
+signals:
+    void updated();
+
+private:
+    static const int sampleInterval = 2000;
+
+    QTimer timer;
+    qint64 processId;
+
+    QElapsedTimer sessionTimer;
+    QElapsedTimer sampleTimer;
+
+    // Last sample
+    double cpuLoad;
+    qint64 rss;
+    int threads;
+    qint64 readBytes;
+    qint64 writtenBytes;
+
+    // Session totals
+    int sampleCount;
+    double cpuLoadSum;
+    double cpuLoadPeak;
+    qint64 rssPeak;
+    int threadsPeak;
+
+    qint64 lastCpuTicks;
+
+    int gcCount;
+    double gcPauseSum;
+    double gcPauseMax;
+    qint64 heapAfterGc;
+
+    QRegularExpression gcPattern;
+
+    static bool readCpuTicks(qint64 pid, qint64 *ticks);
+    static bool readStatus(qint64 pid, qint64 *rss, int *threads);
+    static bool readIo(qint64 pid, qint64 *readBytes,
+                       qint64 *writtenBytes);
+
+    static QString formatSize(qint64 bytes);
+
+private slots:
+    void sample();
+};
+
+#endif // GAMEMONITOR_H
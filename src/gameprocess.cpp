@@ -0,0 +1,267 @@
+#include "gameprocess.h"
+
+#include <QtCore>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+#ifdef Q_OS_LINUX
+// From linux/ioprio.h, which is not installed everywhere
+static const int ioprioClassShift = 13;
+static const int ioprioWhoProcess = 1;
+static const int ioprioClassBestEffort = 2;
+static const int ioprioClassIdle = 3;
+#endif
+
+GameProcess::GameProcess(QObject *parent) : QProcess(parent)
+{
+    niceLevel = 0;
+    ioClass = IoClassDefault;
+}
+
+void GameProcess::setCpuAffinity(const QList<int> &cpus)
+{
+    cpuAffinity = cpus;
+}
+
+void GameProcess::setNiceLevel(int level)
+{
+    niceLevel = level;
+}
+
+void GameProcess::setIoClass(int ioClass)
+{
+    this->ioClass = ioClass;
+}
+
+bool GameProcess::setMemoryLimit(int limit, QString *error)
+{
+#ifdef Q_OS_LINUX
+    // The game group is a sibling of the launcher's own group: processes
+    // can't live in a group whose controllers are delegated to children
+    QString ownGroup = findOwnCgroup();
+    if ( ownGroup.isEmpty() )
+    {
+        *error = tr("Unified control group hierarchy is not available.");
+        return false;
+    }
+
+    QString parentGroup = QFileInfo(ownGroup).path();
+    QString groupDir = "/sys/fs/cgroup" + parentGroup + "/ttyhlauncher-game";
+
+    QDir dir;
+    if ( !dir.mkpath(groupDir) )
+    {
+        *error = tr("Can't create control group %1.").arg(groupDir);
+        return false;
+    }
+
+    QFile memoryMax(groupDir + "/memory.max");
+    if ( !memoryMax.open(QIODevice::WriteOnly) )
+    {
+        *error = tr("Memory controller is not available for %1.")
+                 .arg(groupDir);
+        return false;
+    }
+
+    qint64 bytes = qint64(limit) * 1024 * 1024;
+    memoryMax.write( QByteArray::number(bytes) );
+    memoryMax.close();
+
+    QString procs = groupDir + "/cgroup.procs";
+    if ( !QFileInfo(procs).isWritable() )
+    {
+        *error = tr("Can't move processes to %1.").arg(groupDir);
+        return false;
+    }
+
+    cgroupProcs = QFile::encodeName(procs);
+    return true;
+#else
+    Q_UNUSED(limit);
+
+    *error = tr("Control groups are supported only on Linux.");
+    return false;
+#endif
+}
+
+QString GameProcess::findOwnCgroup()
+{
+    QFile file("/proc/self/cgroup");
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return "";
+    }
+
+    // Unified hierarchy is listed as "0::/path"
+    foreach ( QByteArray line, file.readAll().split('\n') )
+    {
+        if ( line.startsWith("0::/") )
+        {
+            return QString::fromLocal8Bit( line.mid(3) );
+        }
+    }
+
+    return "";
+}
+
+void GameProcess::setupChildProcess()
+{
+    // Runs in the forked child: only async-signal-safe calls are allowed,
+    // so every error is ignored and the game starts anyway
+#ifdef Q_OS_LINUX
+    if ( !cpuAffinity.isEmpty() )
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        for (int i = 0; i < cpuAffinity.count(); i++)
+        {
+            int cpu = cpuAffinity.at(i);
+            if (cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &set);
+            }
+        }
+
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    if (ioClass != IoClassDefault)
+    {
+        int value = ioClass == IoClassIdle
+                ? ioprioClassIdle << ioprioClassShift
+                : (ioprioClassBestEffort << ioprioClassShift) | 7;
+
+        syscall(SYS_ioprio_set, ioprioWhoProcess, 0, value);
+    }
+
+    if ( !cgroupProcs.isEmpty() )
+    {
+        int fd = ::open(cgroupProcs.constData(), O_WRONLY);
+        if (fd != -1)
+        {
+            char buffer[16];
+            int length = 0;
+
+            // Digits of the pid in reverse order
+            char digits[16];
+            int count = 0;
+            for (pid_t pid = getpid(); pid > 0; pid /= 10)
+            {
+                digits[count++] = '0' + pid % 10;
+            }
+
+            while (count > 0)
+            {
+                buffer[length++] = digits[--count];
+            }
+
+            ssize_t written = ::write(fd, buffer, length);
+            Q_UNUSED(written);
+
+            ::close(fd);
+        }
+    }
+#endif
+
+#ifdef Q_OS_UNIX
+    if (niceLevel != 0)
+    {
+        setpriority(PRIO_PROCESS, 0, niceLevel);
+    }
+#endif
+}
+
+void GameProcess::applyScheduling()
+{
+#ifdef Q_OS_WIN
+    HANDLE process = pid()->hProcess;
+
+    if (niceLevel != 0)
+    {
+        DWORD priorityClass = NORMAL_PRIORITY_CLASS;
+
+        if (niceLevel < 0)
+        {
+            priorityClass = ABOVE_NORMAL_PRIORITY_CLASS;
+        }
+        else if (niceLevel >= 15)
+        {
+            priorityClass = IDLE_PRIORITY_CLASS;
+        }
+        else if (niceLevel >= 5)
+        {
+            priorityClass = BELOW_NORMAL_PRIORITY_CLASS;
+        }
+
+        SetPriorityClass(process, priorityClass);
+    }
+
+    if ( !cpuAffinity.isEmpty() )
+    {
+        DWORD_PTR mask = 0;
+        foreach (int cpu, cpuAffinity)
+        {
+            if ( cpu < int(sizeof(mask) * 8) )
+            {
+                mask |= DWORD_PTR(1) << cpu;
+            }
+        }
+
+        SetProcessAffinityMask(process, mask);
+    }
+#endif
+}
+
+bool GameProcess::parseCpuList(const QString &text, QList<int> *cpus)
+{
+    cpus->clear();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    QStringList parts = text.split(',', Qt::SkipEmptyParts);
+#else
+    QStringList parts = text.split(',', QString::SkipEmptyParts);
+#endif
+
+    foreach (QString part, parts)
+    {
+        QStringList range = part.trimmed().split('-');
+        if (range.count() > 2)
+        {
+            return false;
+        }
+
+        bool firstOk, lastOk;
+        int first = range.first().toInt(&firstOk);
+        int last = range.last().toInt(&lastOk);
+
+        if (!firstOk || !lastOk || first < 0 || last < first
+            || last >= maxCpuCount)
+        {
+            return false;
+        }
+
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            if ( !cpus->contains(cpu) )
+            {
+                cpus->append(cpu);
+            }
+        }
+    }
+
+    return true;
+}
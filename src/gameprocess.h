@@ -0,0 +1,52 @@
+#ifndef GAMEPROCESS_H
+#define GAMEPROCESS_H
+
+#include <QProcess>
+
+// Game process with scheduling options applied at spawn time.
+// On Unix the options are set in the child before exec, on Windows
+// priority and affinity are set right after the process is created
+class GameProcess : public QProcess
+{
+    Q_OBJECT
+
+public:
+    enum IoClass
+    {
+        IoClassDefault,
+        IoClassBestEffort,
+        IoClassIdle
+    };
+
+    explicit GameProcess(QObject *parent = 0);
+
+    void setCpuAffinity(const QList<int> &cpus);
+    void setNiceLevel(int level);
+    void setIoClass(int ioClass);
+
+    // Moves the game to a new control group with given memory limit
+    bool setMemoryLimit(int limit, QString *error);
+
+    // Must be called after start on systems without setupChildProcess
+    void applyScheduling();
+
+    // Parses lists like "0-3,6", returns false on bad syntax
+    static bool parseCpuList(const QString &text, QList<int> *cpus);
+
+protected:
+    void setupChildProcess();
+
+private:
+    static const int maxCpuCount = 1024;
+
+    QList<int> cpuAffinity;
+    int niceLevel;
+    int ioClass;
+
+    // Path to cgroup.procs, encoded before fork
+    QByteArray cgroupProcs;
+
+    static QString findOwnCgroup();
+};
+
+#endif // GAMEPROCESS_H
@@ -4,6 +4,12 @@
 
 #include "util.h"
 #include "jsonparser.h"
+#include "localversions.h"
+#include "jvmtuner.h"
+#include "javaregistry.h"
+
+// Windows limits command line to 32767 characters
+static const int maxCommandLength = 32000;
 
 GameRunner::GameRunner(const QString &login, const QString &pass,
                        bool onlineMode, const QRect &windowGeometry,
@@ -23,6 +29,7 @@ GameRunner::GameRunner(const QString &login, const QString &pass,
     version = settings->loadClientVersion();
 
     checker = new HashChecker();
+    checker->setUseManifest(true);
     checker->moveToThread(&checkThread);
 
     connect(&checkThread, &QThread::finished, checker, &QObject::deleteLater);
@@ -35,13 +42,41 @@ GameRunner::GameRunner(const QString &login, const QString &pass,
     connect(checker, &HashChecker::finished,
             this, &GameRunner::runGame);
 
+    connect(&monitor, &GameMonitor::updated,
+            this, &GameRunner::onMonitorUpdated);
+
+    connect(&crashWatcher, &CrashWatcher::reportFound,
+            this, &GameRunner::onCrashReportFound);
+
     checkThread.start();
+
+    gameLogWriter = new GameLog( settings->getBaseDir() );
+    gameLogWriter->setMinimalLevel( settings->loadClientGameLogLevel() );
+    gameLogWriter->setForwardGcLines( settings->loadClientGcLogState() );
+    gameLogWriter->moveToThread(&logThread);
+
+    connect(&logThread, &QThread::finished,
+            gameLogWriter, &QObject::deleteLater);
+
+    connect(this, &GameRunner::gameOutput,
+            gameLogWriter, &GameLog::feed);
+
+    connect(this, &GameRunner::gameOutputFinished,
+            gameLogWriter, &GameLog::finish);
+
+    connect(gameLogWriter, &GameLog::gcLine,
+            &monitor, &GameMonitor::parseGcLine);
+
+    logThread.start();
 }
 
 GameRunner::~GameRunner()
 {
     checkThread.quit();
     checkThread.wait();
+
+    logThread.quit();
+    logThread.wait();
 }
 
 void GameRunner::Run()
@@ -157,35 +192,10 @@ void GameRunner::determinateVersion()
         {
             log("Looking for local versions...");
 
-            JsonParser parser;
-
-            QString time = "1991-05-18T13:15:00+07:00";
-            QDateTime oldTime = QDateTime::fromString(time, Qt::ISODate);
-
             QString path = settings->getVersionsDir();
-            foreach ( QString ver, QDir(path).entryList() )
-            {
-                QFile file(path + "/" + ver + "/" + ver + ".json");
-
-                if ( file.open(QIODevice::ReadOnly) )
-                {
-                    if ( parser.setJson( file.readAll() ) )
-                    {
-                        if ( parser.hasReleaseTime() )
-                        {
-                            QDateTime relTime = parser.getReleaseTime();
-                            if ( relTime.isValid() && (relTime > oldTime) )
-                            {
-                                oldTime = relTime;
-                                version = ver;
-                            }
-                        }
-                    }
-                    file.close();
-                }
-            }
+            version = LocalVersions::findLatest(path);
 
-            if (version == "latest")
+            if ( version.isEmpty() )
             {
                 QString message = tr("Local versions not found.");
                 emitError(message);
@@ -399,129 +409,23 @@ void GameRunner::checkFiles()
 {
     log( tr("Prepare file list for checking...") );
 
-    JsonParser dataParser, assetsParser;
-
-    QString versionDir = settings->getVersionsDir() + "/" + version + "/";
-    QString versionIndexPath = versionDir + version + ".json";
-    QString dataIndexPath = versionDir + "data.json";
-
-    if ( !versionParser.setJsonFromFile(versionIndexPath) )
-    {
-        QString message = tr("Can't parse version index! %1");
-        emitError( message.arg( versionParser.getParserError() ) );
-        return;
-    }
-
-    if ( !dataParser.setJsonFromFile(dataIndexPath) )
-    {
-        QString message = tr("Can't parse data index! %1");
-        emitError( message.arg( dataParser.getParserError() ) );
-        return;
-    }
+    LaunchEnvironment environment = LaunchEnvironment::current(version);
 
-    // Main JAR
-    if ( !dataParser.hasJarFileInfo() )
+    if ( LaunchPreparer::instance()->takePlan(environment, &plan) )
     {
-        emitError( tr("Main JAR does not described in data index.") );
-        return;
+        log( tr("Using launch data prepared in background.") );
     }
-
-    FileInfo jar;
-
-    jar.name = versionDir + version + ".jar";
-    jar.hash = dataParser.getJarFileInfo().hash;
-    jar.size = dataParser.getJarFileInfo().size;
-    jar.url = settings->getVersionUrl(version) + version + ".jar";
-
-    checkList.append(jar);
-
-    // Libraries
-    if ( !versionParser.hasLibraryList() )
-    {
-        emitError( tr("Libraries are not described in data index.") );
-        return;
-    }
-
-    QString libDir = settings->getLibsDir() + "/";
-    QString libUrl = settings->getLibsUrl();
-
-    QList<LibraryInfo> liblist = versionParser.getLibraryList();
-    foreach (LibraryInfo entry, liblist)
+    else
     {
-        QString lib = entry.name;
-
-        if ( !dataParser.hasLibFileInfo(lib) )
+        QString message;
+        if ( !LaunchPreparer::makePlan(environment, &plan, &message) )
         {
-            emitError( tr("Data index not contains library: %1").arg(lib) );
+            emitError(message);
             return;
         }
-
-        FileInfo fileInfo = dataParser.getLibFileInfo(lib);
-
-        fileInfo.name = libDir + lib;
-        fileInfo.url = libUrl + lib;
-
-        checkList.append(fileInfo);
-    }
-
-    // Addons
-    if ( !dataParser.hasAddonsFilesInfo() )
-    {
-        emitError( tr("Addons are not described in data index.") );
-        return;
-    }
-
-    QString clientPrefix = settings->getClientPrefix(version) + "/";
-    QString addonsUrl = settings->getVersionUrl(version) + "files/";
-
-    QList<FileInfo> addons = dataParser.getAddonsFilesInfo();
-    foreach (FileInfo addon, addons)
-    {
-        QString shortName = addon.name;
-        addon.name = clientPrefix + shortName;
-        addon.url = addonsUrl + shortName;
-
-        checkList.append(addon);
     }
 
-    // Assets
-    if ( settings->loadClientCheckAssetsState() )
-    {
-        if ( !versionParser.hasAssetsVersion() )
-        {
-            emitError( tr("Assets are not described in version index.") );
-            return;
-        }
-
-        QString assetsIndexDir = settings->getAssetsDir() + "/indexes/";
-        QString assetsName = versionParser.getAssetsVesrsion() + ".json";
-
-        if ( !assetsParser.setJsonFromFile(assetsIndexDir + assetsName) )
-        {
-            QString message = tr("Can't parse assets index: ");
-            emitError( message + assetsParser.getParserError() );
-            return;
-        }
-
-        if ( !assetsParser.hasAssetsList() )
-        {
-            emitError( tr("Assets list are not described in index.") );
-            return;
-        }
-
-        QString assetsDir = settings->getAssetsDir() + "/objects/";
-        QString assetsUrl = settings->getAssetsUrl() + "objects/";
-
-        QList<FileInfo> assets = assetsParser.getAssetsList();
-        foreach (FileInfo asset, assets)
-        {
-            QString shortName = asset.name;
-            asset.name = assetsDir + shortName;
-            asset.url = assetsUrl + shortName;
-
-            checkList.append(asset);
-        }
-    }
+    checkList = plan.checkList;
 
     log( tr("Begin files check...") );
     bool stopOnBadHash = isOnline;
@@ -542,90 +446,49 @@ void GameRunner::runGame()
     log( tr("Prepare run data...") );
 
     // Run game with known uuid, acess token and game version
-    QString java, nativesPath, classpath, cpSep,
-            assetsName, mainClass, minecraftArguments;
-
-    bool loadCustomJava = settings->loadClientJavaState();
-    java = loadCustomJava ? settings->loadClientJava() : "java";
-
-    bool isWindows = settings->getOsName() == "windows";
-    cpSep = isWindows ? ";" : ":";
+    QString java, nativesPath;
 
-    nativesPath = settings->getNativesDir();
-    Util::removeAll(nativesPath);
+    // Custom Java is used as is, otherwise the closest known runtime
+    JavaRuntime runtime;
+    bool isKnownRuntime;
 
-    QDir libsDir = QDir(nativesPath);
-    libsDir.mkpath(nativesPath);
+    JavaRegistry *registry = JavaRegistry::instance();
 
-    if ( !libsDir.exists() )
+    if ( settings->loadClientJavaState() )
     {
-        emitError( tr("Can't create natives directory!") );
-        return;
+        java = settings->loadClientJava();
+        isKnownRuntime = registry->findRuntime(java, &runtime);
     }
-
-    QString libDir = settings->getLibsDir() + "/";
-
-    QList<LibraryInfo> libList = versionParser.getLibraryList();
-    foreach (LibraryInfo libInfo, libList)
+    else
     {
-        if (libInfo.isNative)
-        {
-            Util::unzipArchive(libDir + libInfo.name, nativesPath);
-        }
-        else
-        {
-            classpath += libDir + libInfo.name + cpSep;
-        }
+        isKnownRuntime = registry->selectRuntime(plan.javaVersion, &runtime);
+        java = isKnownRuntime ? runtime.path : "java";
     }
 
-    QString versionsDir = settings->getVersionsDir() + "/";
-    classpath += versionsDir + "/" + version + "/" + version + ".jar";
-
-    if ( !versionParser.hasMainClass() )
+    if (isKnownRuntime)
     {
-        QString message = tr("No main class in %1.json!").arg(version);
-        emitError(message);
-        return;
-    }
-    mainClass = versionParser.getMainClass();
+        log( tr("Using Java %1 (%2) from %3")
+             .arg(runtime.version).arg(runtime.vendor).arg(runtime.path) );
 
-    if ( !versionParser.hasAssetsVersion() )
-    {
-        QString message = tr("No assets in %1.json!").arg(version);
-        emitError(message);
-        return;
+        if ( plan.javaVersion > runtime.majorVersion )
+        {
+            log( tr("Warning! Java %1 is required.").arg(plan.javaVersion) );
+        }
     }
-    assetsName = versionParser.getAssetsVesrsion();
 
-    if ( !versionParser.hasMinecraftArgs() )
+    // Natives are usually extracted already by the launch preparer
+    nativesPath = plan.environment.nativesDir;
+
+    if ( !LaunchPreparer::prepareNatives(plan) )
     {
-        QString message = tr("No minecraft args in %1.json!").arg(version);
-        emitError(message);
+        emitError( tr("Can't create natives directory!") );
         return;
     }
-    minecraftArguments = versionParser.getMinecraftArgs();
 
     QString clientPrefix = settings->getClientPrefix(version);
-    QString assetsDir = settings->getAssetsDir();
-    QStringList mcArgList;
-    foreach ( QString mcArg, minecraftArguments.split(" ") )
-    {
-        mcArg.replace("${auth_player_name}", name);
-        mcArg.replace("${version_name}", version);
-        mcArg.replace("${game_directory}", clientPrefix);
-        mcArg.replace("${assets_root}", assetsDir);
-        mcArg.replace("${assets_index_name}", assetsName);
-        mcArg.replace("${auth_uuid}", clientToken);
-        mcArg.replace("${auth_access_token}", accessToken);
-        mcArg.replace("${user_properties}", "{}");
-        mcArg.replace("${user_type}", "mojang");
-
-        int active = settings->loadActiveClientID();
-        QString clientType = settings->getClientName(active);
-        mcArg.replace("${version_type}", clientType);
 
-        mcArgList << mcArg;
-    }
+    // Static placeholders are resolved in the compiled launch plan
+    QStringList mcArgList = plan.makeGameArgs(name, clientToken, accessToken);
 
     // Width & height/fullscreen args
     if ( settings->loadClientWindowSizeState() )
@@ -674,14 +537,71 @@ void GameRunner::runGame()
         userArgList = settings->loadClientJavaArgs().split(" ");
     }
 
+    // Memory and collector options, user args take precedence
+    if ( settings->loadClientJvmTuningState() )
+    {
+        int heapSize = settings->loadClientHeapSize();
+        int collector = settings->loadClientCollector();
+
+        // Fall back when selected collector isn't supported by the runtime
+        if ( collector == JvmTuner::CollectorZ && isKnownRuntime
+             && !runtime.collectors.contains("Z") )
+        {
+            log( tr("ZGC is not supported by this Java.") );
+            collector = JvmTuner::CollectorAuto;
+        }
+
+        int javaWordSize = 0;
+        int javaVersion = 0;
+        if (isKnownRuntime)
+        {
+            javaWordSize = runtime.is64Bit ? 64 : 32;
+            javaVersion = runtime.majorVersion;
+        }
+
+        QStringList tuningArgs = JvmTuner::makeArgs(heapSize, collector,
+                                                    userArgList,
+                                                    javaWordSize,
+                                                    javaVersion);
+
+        log( tr("JVM tuning: %1").arg( tuningArgs.join(' ') ) );
+        argList << tuningArgs;
+    }
+
     if ( !userArgList.isEmpty() )
     {
         argList << userArgList;
     }
 
-    argList << "-Djava.library.path=" + nativesPath
-            << "-cp" << classpath
-            << mainClass
+    // Unified logging is unknown to Java 8 and it refuses to start
+    if ( settings->loadClientGcLogState() )
+    {
+        if (isKnownRuntime && runtime.majorVersion >= 9)
+        {
+            argList << "-Xlog:gc";
+        }
+        else
+        {
+            log( tr("GC statistics need Java 9 or newer.") );
+        }
+    }
+
+    QStringList cpArgs;
+    cpArgs << "-Djava.library.path=" + nativesPath
+           << "-cp" << plan.classpath;
+
+    int length = java.length() + argList.join(' ').length()
+                 + cpArgs.join(' ').length() + plan.mainClass.length()
+                 + mcArgList.join(' ').length() + 4;
+
+    if ( settings->loadClientCdsState() )
+    {
+        int javaVersion = isKnownRuntime ? runtime.majorVersion : 0;
+        argList << makeCdsArgs(java, javaVersion);
+    }
+
+    argList << makeClasspathArgs(cpArgs, length)
+            << plan.mainClass
             << mcArgList;
 
     minecraft.setProcessChannelMode(QProcess::MergedChannels);
@@ -704,10 +624,128 @@ void GameRunner::runGame()
     connect( &minecraft, SIGNAL(finished(int)), this,
              SLOT(onGameFinished(int)));
 
+    if ( settings->loadClientSchedulingState() )
+    {
+        setupScheduling();
+    }
+
     log( tr("Run string: ") + java + " " + argList.join(' ') );
     minecraft.start(java, argList);
 }
 
+void GameRunner::setupScheduling()
+{
+    QString affinity = settings->loadClientCpuAffinity();
+    QList<int> cpus;
+
+    if ( GameProcess::parseCpuList(affinity, &cpus) )
+    {
+        minecraft.setCpuAffinity(cpus);
+    }
+    else
+    {
+        log( tr("Bad CPU list: %1").arg(affinity) );
+    }
+
+    minecraft.setNiceLevel( settings->loadClientNiceLevel() );
+    minecraft.setIoClass( settings->loadClientIoClass() );
+
+    // Limit is optional, so the game starts without it on failure
+    int memoryLimit = settings->loadClientMemoryLimit();
+    if (memoryLimit > 0)
+    {
+        QString error;
+        if ( minecraft.setMemoryLimit(memoryLimit, &error) )
+        {
+            log( tr("Memory limit: %1 MB").arg(memoryLimit) );
+        }
+        else
+        {
+            log( tr("Can't limit memory! %1").arg(error) );
+        }
+    }
+}
+
+QStringList GameRunner::makeCdsArgs(const QString &java, int javaVersion)
+{
+    QString archive = LaunchPreparer::makeCdsArchivePath(plan, java);
+    QStringList args;
+
+    // Archive options are unknown to Java older than 13
+    if (javaVersion != 0 && javaVersion < 13)
+    {
+        log( tr("Class data archive needs Java 13 or newer.") );
+        return args;
+    }
+
+    // Unknown runtime may be too old for the archive options
+    if (javaVersion == 0)
+    {
+        args << "-XX:+IgnoreUnrecognizedVMOptions";
+    }
+
+    if ( QFile::exists(archive) )
+    {
+        log( tr("Using class data archive %1").arg(archive) );
+        args << "-XX:SharedArchiveFile=" + archive;
+    }
+    else
+    {
+        LaunchPreparer::removeOutdatedFiles(archive, "classes-", ".jsa");
+
+        log( tr("Class data archive will be created at exit.") );
+        args << "-XX:ArchiveClassesAtExit=" + archive;
+
+        dumpedArchive = archive;
+    }
+
+    return args;
+}
+
+QStringList GameRunner::makeClasspathArgs(const QStringList &cpArgs,
+                                          int commandLength)
+{
+    int mode = settings->loadClientClasspathMode();
+
+    if (mode == LaunchPreparer::ClasspathAuto)
+    {
+        bool isTooLong = commandLength > maxCommandLength;
+        mode = isTooLong ? LaunchPreparer::ClasspathJar
+                         : LaunchPreparer::ClasspathCommandLine;
+    }
+
+    if (mode == LaunchPreparer::ClasspathCommandLine)
+    {
+        return cpArgs;
+    }
+
+    QStringList args;
+
+    if (mode == LaunchPreparer::ClasspathJar)
+    {
+        QString jar = LaunchPreparer::prepareClasspathJar(plan);
+        if ( !jar.isEmpty() )
+        {
+            log( tr("Classpath is passed in %1").arg(jar) );
+            args << cpArgs.first() << "-cp" << jar;
+            return args;
+        }
+    }
+    else if (mode == LaunchPreparer::ClasspathArgFile)
+    {
+        QString argFile = LaunchPreparer::prepareArgFile(plan, cpArgs);
+        if ( !argFile.isEmpty() )
+        {
+            log( tr("Classpath is passed in %1").arg(argFile) );
+            args << "@" + argFile;
+            return args;
+        }
+    }
+
+    log( tr("Can't write classpath file, using command line.") );
+    return cpArgs;
+}
+
 void GameRunner::log(const QString &text)
 {
     logger->appendLine(tr("GameRunner"), text);
@@ -715,7 +753,7 @@ void GameRunner::log(const QString &text)
 
 void GameRunner::gameLog()
 {
-    logger->appendLine( tr("Game"), minecraft.readAll().trimmed() );
+    emit gameOutput( minecraft.readAll() );
 }
 
 void GameRunner::onGameError(QProcess::ProcessError error)
@@ -754,15 +792,63 @@ void GameRunner::onGameError(QProcess::ProcessError error)
 void GameRunner::onGameStarted()
 {
     log( tr("Game started.") );
+
+    minecraft.applyScheduling();
+
+    monitor.start( minecraft.processId() );
+    crashWatcher.start( settings->getClientPrefix(version) );
     emit started();
 }
 
 void GameRunner::onGameFinished(int exitCode)
 {
+    // Output left in the buffer goes to the game log too
+    emit gameOutput( minecraft.readAll() );
+    emit gameOutputFinished();
+
     log( tr("Game finished with code %1.").arg(exitCode) );
+
+    monitor.stop();
+
+    // Fatal error log may be written just before the exit
+    crashWatcher.check();
+    crashWatcher.stop();
+    foreach ( QString line, monitor.summarize().split('\n') )
+    {
+        log(line);
+    }
+
+    // Archive may be incomplete after failed run
+    bool isFailed = exitCode != 0
+                    || minecraft.exitStatus() == QProcess::CrashExit;
+
+    if ( !dumpedArchive.isEmpty() && isFailed )
+    {
+        log( tr("Removing class data archive of failed run.") );
+        QFile::remove(dumpedArchive);
+    }
+
     emit finished(exitCode);
 }
 
+void GameRunner::onMonitorUpdated()
+{
+    emit statsChanged( monitor.describe() );
+}
+
+void GameRunner::onCrashReportFound(const QString &path)
+{
+    QString reason = CrashWatcher::describeReport(path);
+
+    log( tr("Crash report found: %1").arg(path) );
+    if ( !reason.isEmpty() )
+    {
+        log( tr("Crash reason: %1").arg(reason) );
+    }
+
+    emit crashReported(path, reason);
+}
+
 void GameRunner::emitError(const QString &message)
 {
     log( tr("Error! %1").arg(message) );
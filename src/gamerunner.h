@@ -11,6 +11,11 @@
 #include "hashchecker.h"
 #include "fileinfo.h"
 #include "libraryinfo.h"
+#include "launchpreparer.h"
+#include "gamemonitor.h"
+#include "gameprocess.h"
+#include "gamelog.h"
+#include "crashwatcher.h"
 
 class GameRunner : public QObject
 {
@@ -28,8 +33,17 @@ signals:
     void started();
     void finished(int exitCode);
 
+    // Short resource usage report while the game is running
+    void statsChanged(const QString &stats);
+
+    // Crash report or JVM fatal error log written during the session
+    void crashReported(const QString &path, const QString &reason);
+
     void beginCheck(const QList<FileInfo> list, bool stopOnBad);
 
+    void gameOutput(const QByteArray &output);
+    void gameOutputFinished();
+
 private:
     // Initial data
     QString name;
@@ -59,8 +73,17 @@ private:
     QList<FileInfo> checkList;
 
     // Run data
-    JsonParser versionParser;
-    QProcess minecraft;
+    LaunchPlan plan;
+    GameProcess minecraft;
+    GameMonitor monitor;
+    CrashWatcher crashWatcher;
+
+    // Game output is parsed and written away from the main thread
+    QThread logThread;
+    GameLog *gameLogWriter;
+
+    // Class data sharing archive written by this run
+    QString dumpedArchive;
 
     // Additional data
     Settings *settings;
@@ -82,6 +105,11 @@ private:
     void checkFiles();
     void runGame();
 
+    QStringList makeClasspathArgs(const QStringList &cpArgs,
+                                  int commandLength);
+    QStringList makeCdsArgs(const QString &java, int javaVersion);
+    void setupScheduling();
+
     void readVersionIndexInfo(const QString &indexName);
     void emitError(const QString &message);
     void emitNeedUpdate(const QString &message);
@@ -100,6 +128,9 @@ private slots:
     void onGameError(QProcess::ProcessError error);
     void onGameStarted();
     void onGameFinished(int exitCode);
+
+    void onMonitorUpdated();
+    void onCrashReportFound(const QString &path);
 };
 
 #endif // GAMERUNNER_H
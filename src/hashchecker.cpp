@@ -1,8 +1,16 @@
 #include "hashchecker.h"
+#include "installmanifest.h"
 
 HashChecker::HashChecker()
 {
     qRegisterMetaType<QList<FileInfo> >("QList<FileInfo>");
+
+    useManifest = false;
+}
+
+void HashChecker::setUseManifest(bool state)
+{
+    useManifest = state;
 }
 
 void HashChecker::checkFiles(const QList<FileInfo> &list, bool stopOnBad)
@@ -28,11 +36,13 @@ void HashChecker::checkFiles(const QList<FileInfo> &list, bool stopOnBad)
 
             if (stopOnBad)
             {
+                InstallManifest::instance()->save();
                 return;
             }
         }
     }
 
+    InstallManifest::instance()->save();
     emit finished();
 }
 
@@ -48,7 +58,21 @@ bool HashChecker::checkFile(const FileInfo fileInfo) const
         return true;
     }
 
-    return isFileHashValid(fileInfo.name, fileInfo.hash);
+    InstallManifest *manifest = InstallManifest::instance();
+
+    if ( useManifest && manifest->isFileValid(fileInfo.name, fileInfo.hash) )
+    {
+        return true;
+    }
+
+    if ( !isFileHashValid(fileInfo.name, fileInfo.hash) )
+    {
+        return false;
+    }
+
+    // Remember verified file to check it by metadata next time
+    manifest->update(fileInfo.name, fileInfo.hash);
+    return true;
 }
 
 void HashChecker::cancel()
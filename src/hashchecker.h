@@ -13,6 +13,9 @@ public:
     HashChecker();
     void cancel();
 
+    // Accept files known to the install manifest without reading them
+    void setUseManifest(bool state);
+
     static QString getDataHash(const QByteArray &data);
     static QString getFileHash(const QString &path);
     static bool isFileHashValid(const QString &path, const QString &hash);
@@ -24,6 +27,7 @@ private:
     bool checkFile(const FileInfo fileInfo) const;
 
     bool cancelled;
+    bool useManifest;
 
 signals:
     void progress(int percents);
@@ -0,0 +1,146 @@
+#include "installmanifest.h"
+#include "settings.h"
+#include "logger.h"
+
+InstallManifest *InstallManifest::myInstance = NULL;
+InstallManifest *InstallManifest::instance()
+{
+    if (myInstance == NULL)
+    {
+        myInstance = new InstallManifest();
+    }
+    return myInstance;
+}
+
+InstallManifest::InstallManifest(QObject *parent) :
+    QObject(parent)
+{
+    changed = false;
+    fileName = Settings::instance()->getBaseDir() + "/install_manifest.json";
+
+    load();
+}
+
+void InstallManifest::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("InstallManifest"), text);
+}
+
+void InstallManifest::load()
+{
+    QFile file(fileName);
+    if ( !file.exists() )
+    {
+        return;
+    }
+
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        log( tr("Error! %1").arg( file.errorString() ) );
+        return;
+    }
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(file.readAll(), &error);
+    file.close();
+
+    if (error.error != QJsonParseError::NoError)
+    {
+        log( tr("Error! %1").arg( error.errorString() ) );
+        return;
+    }
+
+    QJsonObject files = json.object()["files"].toObject();
+    foreach ( QString path, files.keys() )
+    {
+        QJsonObject object = files[path].toObject();
+
+        Entry entry;
+        entry.hash = object["hash"].toString();
+        entry.size = qint64( object["size"].toDouble() );
+        entry.mtime = qint64( object["mtime"].toDouble() );
+
+        entries.insert(path, entry);
+    }
+}
+
+bool InstallManifest::isFileValid(const QString &path, const QString &hash)
+{
+    QMutexLocker locker(&mutex);
+
+    if ( !entries.contains(path) )
+    {
+        return false;
+    }
+
+    const Entry &entry = entries[path];
+    if ( entry.hash.toLower() != hash.toLower() )
+    {
+        return false;
+    }
+
+    QFileInfo info(path);
+    return info.exists()
+           && info.size() == entry.size
+           && info.lastModified().toMSecsSinceEpoch() == entry.mtime;
+}
+
+void InstallManifest::update(const QString &path, const QString &hash)
+{
+    QFileInfo info(path);
+
+    Entry entry;
+    entry.hash = hash;
+    entry.size = info.size();
+    entry.mtime = info.lastModified().toMSecsSinceEpoch();
+
+    QMutexLocker locker(&mutex);
+    entries.insert(path, entry);
+    changed = true;
+}
+
+void InstallManifest::remove(const QString &path)
+{
+    QMutexLocker locker(&mutex);
+    if ( entries.remove(path) > 0 )
+    {
+        changed = true;
+    }
+}
+
+void InstallManifest::save()
+{
+    QMutexLocker locker(&mutex);
+    if (!changed)
+    {
+        return;
+    }
+
+    QJsonObject files;
+    QHash<QString, Entry>::const_iterator i;
+    for (i = entries.constBegin(); i != entries.constEnd(); ++i)
+    {
+        QJsonObject object;
+        object["hash"] = i.value().hash;
+        object["size"] = double( i.value().size );
+        object["mtime"] = double( i.value().mtime );
+
+        files[ i.key() ] = object;
+    }
+
+    QJsonObject root;
+    root["files"] = files;
+
+    QSaveFile file(fileName);
+    if ( file.open(QIODevice::WriteOnly) )
+    {
+        file.write( QJsonDocument(root).toJson(QJsonDocument::Compact) );
+        if ( file.commit() )
+        {
+            changed = false;
+            return;
+        }
+    }
+
+    log( tr("Error! %1").arg( file.errorString() ) );
+}
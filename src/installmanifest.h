@@ -0,0 +1,46 @@
+#ifndef INSTALLMANIFEST_H
+#define INSTALLMANIFEST_H
+
+#include <QtCore>
+
+// Remembers size and modification time of files with known hashes,
+// so unchanged files can be accepted without reading them
+class InstallManifest : public QObject
+{
+    Q_OBJECT
+
+public:
+    static InstallManifest *instance();
+
+    bool isFileValid(const QString &path, const QString &hash);
+    void update(const QString &path, const QString &hash);
+    void remove(const QString &path);
+
+    void save();
+
+private:
+    explicit InstallManifest(QObject *parent = 0);
+
+    static InstallManifest *myInstance;
+
+    struct Entry
+    {
+        QString hash;
+        qint64 size;
+        qint64 mtime;
+    };
+
+    QMutex mutex;
+    QHash<QString, Entry> entries;
+
+    QString fileName;
+    bool changed;
+
+    void load();
+    void log(const QString &text);
+
+    InstallManifest &operator=(InstallManifest const &);
+    InstallManifest(InstallManifest const &);
+};
+
+#endif // INSTALLMANIFEST_H
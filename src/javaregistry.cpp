@@ -0,0 +1,435 @@
+#include "javaregistry.h"
+#include "settings.h"
+#include "logger.h"
+
+// Scans Java runtimes in the registry's thread pool
+class ScanTask : public QRunnable
+{
+public:
+    ScanTask(JavaRegistry *javaRegistry, const QStringList &paths)
+    {
+        registry = javaRegistry;
+        extraPaths = paths;
+    }
+
+    void run()
+    {
+        registry->scan(extraPaths);
+    }
+
+private:
+    JavaRegistry *registry;
+    QStringList extraPaths;
+};
+
+JavaRegistry *JavaRegistry::myInstance = NULL;
+JavaRegistry *JavaRegistry::instance()
+{
+    if (myInstance == NULL)
+    {
+        myInstance = new JavaRegistry();
+    }
+    return myInstance;
+}
+
+JavaRegistry::JavaRegistry(QObject *parent) : QObject(parent)
+{
+    fileName = Settings::instance()->getBaseDir() + "/java_runtimes.json";
+
+    // One scan at a time, queued scans find everything cached
+    pool.setMaxThreadCount(1);
+
+    load();
+}
+
+void JavaRegistry::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("JavaRegistry"), text);
+}
+
+void JavaRegistry::refresh(const QStringList &extraPaths)
+{
+    pool.start( new ScanTask(this, extraPaths) );
+}
+
+QList<JavaRuntime> JavaRegistry::getRuntimes()
+{
+    QMutexLocker locker(&mutex);
+
+    QList<JavaRuntime> runtimes;
+    foreach (const Entry &entry, entries)
+    {
+        runtimes.append(entry.runtime);
+    }
+
+    return runtimes;
+}
+
+bool JavaRegistry::findRuntime(const QString &path, JavaRuntime *runtime)
+{
+    QString canonicalPath = QFileInfo(path).canonicalFilePath();
+
+    QMutexLocker locker(&mutex);
+
+    if ( canonicalPath.isEmpty() || !entries.contains(canonicalPath) )
+    {
+        return false;
+    }
+
+    *runtime = entries[canonicalPath].runtime;
+    return true;
+}
+
+bool JavaRegistry::selectRuntime(int requiredVersion, JavaRuntime *runtime)
+{
+    if (requiredVersion <= 0)
+    {
+        requiredVersion = defaultVersion;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    // Required version is the best, then the closest newer one,
+    // then the newest of older ones. 64-bit runtimes are preferred
+    // within each group
+    int bestScore = -1;
+
+    foreach (const Entry &entry, entries)
+    {
+        const JavaRuntime &candidate = entry.runtime;
+        int major = candidate.majorVersion;
+
+        int score;
+        if (major == requiredVersion)
+        {
+            score = 30000;
+        }
+        else if (major > requiredVersion)
+        {
+            score = 20000 - (major - requiredVersion) * 10;
+        }
+        else
+        {
+            score = major * 10;
+        }
+
+        if (candidate.is64Bit)
+        {
+            score += 5;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            *runtime = candidate;
+        }
+    }
+
+    return bestScore >= 0;
+}
+
+QString JavaRegistry::describe()
+{
+    QList<JavaRuntime> runtimes = getRuntimes();
+    if ( runtimes.isEmpty() )
+    {
+        return "No Java runtimes found.\n";
+    }
+
+    QString text;
+    foreach (const JavaRuntime &runtime, runtimes)
+    {
+        text += QString("%1: %2, %3, %4, GC: %5\n")
+                .arg(runtime.path)
+                .arg(runtime.version)
+                .arg(runtime.vendor)
+                .arg(runtime.arch)
+                .arg( runtime.collectors.join(", ") );
+    }
+
+    return text;
+}
+
+int JavaRegistry::parseMajorVersion(const QString &version)
+{
+    // "1.8.0_292" is Java 8, "17.0.2" and "21-ea" are Java 17 and 21
+    QStringList parts = version.split( QRegularExpression("[^0-9]+") );
+
+    int first = parts.value(0).toInt();
+    if (first == 1)
+    {
+        return parts.value(1).toInt();
+    }
+
+    return first;
+}
+
+void JavaRegistry::scan(const QStringList &extraPaths)
+{
+    QStringList candidates = findCandidates(extraPaths);
+
+    QHash<QString, Entry> known;
+
+    mutex.lock();
+    known = entries;
+    mutex.unlock();
+
+    QHash<QString, Entry> found;
+    bool changed = false;
+
+    foreach (const QString &path, candidates)
+    {
+        QFileInfo info(path);
+        qint64 size = info.size();
+        qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+        if ( known.contains(path) )
+        {
+            const Entry &entry = known[path];
+            if (entry.size == size && entry.mtime == mtime)
+            {
+                found.insert(path, entry);
+                continue;
+            }
+        }
+
+        log( tr("Probing Java runtime %1...").arg(path) );
+
+        Entry entry;
+        if ( !probe(path, &entry.runtime) )
+        {
+            log( tr("Can't probe %1!").arg(path) );
+            continue;
+        }
+
+        entry.size = size;
+        entry.mtime = mtime;
+
+        QString message = tr("Found Java %1 (%2, %3).");
+        log( message.arg(entry.runtime.version)
+                    .arg(entry.runtime.vendor)
+                    .arg(entry.runtime.arch) );
+
+        found.insert(path, entry);
+        changed = true;
+    }
+
+    if ( found.count() != known.count() )
+    {
+        changed = true;
+    }
+
+    mutex.lock();
+    entries = found;
+    mutex.unlock();
+
+    if (changed)
+    {
+        save();
+    }
+}
+
+QStringList JavaRegistry::findCandidates(const QStringList &extraPaths)
+{
+    QStringList binaries;
+
+#ifdef Q_OS_WIN
+    QString binary = "bin/javaw.exe";
+#else
+    QString binary = "bin/java";
+#endif
+
+    // Directories with one runtime per subdirectory
+    QStringList roots;
+
+#ifdef Q_OS_LINUX
+    roots << "/usr/lib/jvm" << "/usr/lib64/jvm" << "/usr/java"
+          << "/opt" << "/opt/java" << "/opt/jdk"
+          << QDir::homePath() + "/.sdkman/candidates/java"
+          << QDir::homePath() + "/.jdks";
+#endif
+
+#ifdef Q_OS_WIN
+    QString programFiles = qgetenv("ProgramFiles");
+    roots << programFiles + "/Java"
+          << programFiles + "/Eclipse Adoptium"
+          << programFiles + "/Zulu";
+#endif
+
+#ifdef Q_OS_OSX
+    roots << "/Library/Java/JavaVirtualMachines";
+    binary = "Contents/Home/" + binary;
+#endif
+
+    foreach (const QString &root, roots)
+    {
+        QDir dir(root);
+        QDir::Filters filters = QDir::Dirs | QDir::NoDotAndDotDot;
+
+        foreach ( QString name, dir.entryList(filters) )
+        {
+            binaries << root + "/" + name + "/" + binary;
+        }
+    }
+
+    QString javaHome = qgetenv("JAVA_HOME");
+    if ( !javaHome.isEmpty() )
+    {
+        binaries << javaHome + "/bin/java";
+    }
+
+    binaries << QStandardPaths::findExecutable("java");
+    binaries << extraPaths;
+
+    // Symlinks like /usr/bin/java lead to runtimes from the list above
+    QStringList candidates;
+    foreach (const QString &path, binaries)
+    {
+        QFileInfo info(path);
+        QString canonicalPath = info.canonicalFilePath();
+
+        if ( !canonicalPath.isEmpty() && info.isExecutable()
+             && !candidates.contains(canonicalPath) )
+        {
+            candidates << canonicalPath;
+        }
+    }
+
+    return candidates;
+}
+
+bool JavaRegistry::probe(const QString &path, JavaRuntime *runtime)
+{
+    QStringList args;
+    args << "-XshowSettings:properties" << "-XX:+PrintFlagsFinal"
+         << "-version";
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(path, args);
+
+    if ( !process.waitForStarted(probeTimeout)
+         || !process.waitForFinished(probeTimeout) )
+    {
+        process.kill();
+        process.waitForFinished();
+        return false;
+    }
+
+    QString output = QString::fromLocal8Bit( process.readAll() );
+
+    runtime->path = path;
+    runtime->is64Bit = false;
+
+    // Flags look like "bool UseG1GC    = true   {product} {default}"
+    QRegularExpression collector("^bool\\s+Use(\\w+)GC\\s");
+
+    foreach ( QString line, output.split('\n') )
+    {
+        line = line.trimmed();
+
+        QString key = line.section(" = ", 0, 0);
+        QString value = line.section(" = ", 1);
+
+        if (key == "java.version")
+        {
+            runtime->version = value;
+        }
+        else if (key == "java.vendor")
+        {
+            runtime->vendor = value;
+        }
+        else if (key == "os.arch")
+        {
+            runtime->arch = value;
+        }
+        else if (key == "sun.arch.data.model")
+        {
+            runtime->is64Bit = value == "64";
+        }
+
+        QRegularExpressionMatch match = collector.match(line);
+        if ( match.hasMatch() )
+        {
+            runtime->collectors << match.captured(1);
+        }
+    }
+
+    runtime->majorVersion = parseMajorVersion(runtime->version);
+    return runtime->majorVersion > 0;
+}
+
+void JavaRegistry::load()
+{
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return;
+    }
+
+    QJsonDocument json = QJsonDocument::fromJson( file.readAll() );
+    file.close();
+
+    QJsonObject runtimes = json.object()["runtimes"].toObject();
+    foreach ( QString path, runtimes.keys() )
+    {
+        QJsonObject object = runtimes[path].toObject();
+
+        Entry entry;
+        entry.size = qint64( object["size"].toDouble() );
+        entry.mtime = qint64( object["mtime"].toDouble() );
+
+        JavaRuntime &runtime = entry.runtime;
+        runtime.path = path;
+        runtime.version = object["version"].toString();
+        runtime.majorVersion = parseMajorVersion(runtime.version);
+        runtime.vendor = object["vendor"].toString();
+        runtime.arch = object["arch"].toString();
+        runtime.is64Bit = object["is64Bit"].toBool();
+
+        foreach ( QJsonValue value, object["collectors"].toArray() )
+        {
+            runtime.collectors << value.toString();
+        }
+
+        entries.insert(path, entry);
+    }
+}
+
+void JavaRegistry::save()
+{
+    QJsonObject runtimes;
+
+    mutex.lock();
+    foreach (const Entry &entry, entries)
+    {
+        const JavaRuntime &runtime = entry.runtime;
+
+        QJsonObject object;
+        object["size"] = double(entry.size);
+        object["mtime"] = double(entry.mtime);
+        object["version"] = runtime.version;
+        object["vendor"] = runtime.vendor;
+        object["arch"] = runtime.arch;
+        object["is64Bit"] = runtime.is64Bit;
+        object["collectors"] = QJsonArray::fromStringList(runtime.collectors);
+
+        runtimes[runtime.path] = object;
+    }
+    mutex.unlock();
+
+    QJsonObject root;
+    root["runtimes"] = runtimes;
+
+    QSaveFile file(fileName);
+    if ( file.open(QIODevice::WriteOnly) )
+    {
+        file.write( QJsonDocument(root).toJson(QJsonDocument::Compact) );
+        if ( file.commit() )
+        {
+            return;
+        }
+    }
+
+    log( tr("Error! %1").arg( file.errorString() ) );
+}
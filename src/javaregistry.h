@@ -0,0 +1,79 @@
+#ifndef JAVAREGISTRY_H
+#define JAVAREGISTRY_H
+
+#include <QtCore>
+
+// Java runtime found on this computer
+struct JavaRuntime
+{
+    QString path;
+    QString version;
+    int majorVersion;
+    QString vendor;
+    QString arch;
+    bool is64Bit;
+
+    // Supported garbage collectors: "G1", "Z", "Shenandoah", ...
+    QStringList collectors;
+};
+
+// Finds installed Java runtimes and remembers what they support.
+// Every binary is probed once, results are kept until it is changed
+class JavaRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static JavaRegistry *instance();
+
+    // Rescans runtimes in background, extra paths are probed too
+    void refresh(const QStringList &extraPaths);
+
+    QList<JavaRuntime> getRuntimes();
+    bool findRuntime(const QString &path, JavaRuntime *runtime);
+
+    // Chooses runtime closest to required major version
+    bool selectRuntime(int requiredVersion, JavaRuntime *runtime);
+
+    QString describe();
+
+    static int parseMajorVersion(const QString &version);
+
+private:
+    explicit JavaRegistry(QObject *parent = 0);
+
+    static JavaRegistry *myInstance;
+
+    // LaunchWrapper clients don't run on Java 9 and newer
+    static const int defaultVersion = 8;
+    static const int probeTimeout = 15000;
+
+    struct Entry
+    {
+        JavaRuntime runtime;
+        qint64 size;
+        qint64 mtime;
+    };
+
+    QThreadPool pool;
+
+    QMutex mutex;
+    QHash<QString, Entry> entries;
+
+    QString fileName;
+
+    void scan(const QStringList &extraPaths);
+    static QStringList findCandidates(const QStringList &extraPaths);
+    static bool probe(const QString &path, JavaRuntime *runtime);
+
+    void load();
+    void save();
+    void log(const QString &text);
+
+    friend class ScanTask;
+
+    JavaRegistry &operator=(JavaRegistry const &);
+    JavaRegistry(JavaRegistry const &);
+};
+
+#endif // JAVAREGISTRY_H
@@ -154,6 +154,23 @@ QHash<QString, QString> JsonParser::getPrefixesList() const
     return result;
 }
 
+bool JsonParser::hasMirrorList() const
+{
+    return jsonObject["mirrors"].isArray();
+}
+
+QStringList JsonParser::getMirrorList() const
+{
+    QStringList result;
+
+    foreach ( QJsonValue value, jsonObject["mirrors"].toArray() )
+    {
+        result << value.toString();
+    }
+
+    return result;
+}
+
 bool JsonParser::hasReleaseTime() const
 {
     return hasStringKey("releaseTime");
@@ -204,6 +221,16 @@ QString JsonParser::getMinecraftArgs() const
     return getStringKey("minecraftArguments");
 }
 
+bool JsonParser::hasJavaVersion() const
+{
+    return jsonObject["javaVersion"].toObject()["majorVersion"].isDouble();
+}
+
+int JsonParser::getJavaVersion() const
+{
+    return jsonObject["javaVersion"].toObject()["majorVersion"].toInt();
+}
+
 bool JsonParser::hasLibraryList() const
 {
     return jsonObject["libraries"].isArray();
@@ -44,6 +44,9 @@ public:
     bool hasPrefixesList() const;
     QHash<QString, QString> getPrefixesList() const;
 
+    bool hasMirrorList() const;
+    QStringList getMirrorList() const;
+
     // Parse version.json
     bool hasReleaseTime() const;
     QDateTime getReleaseTime() const;
@@ -60,6 +63,9 @@ public:
     bool hasMinecraftArgs() const;
     QString getMinecraftArgs() const;
 
+    bool hasJavaVersion() const;
+    int getJavaVersion() const;
+
     bool hasLibraryList() const;
     QList<LibraryInfo> getLibraryList() const;
 
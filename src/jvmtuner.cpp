@@ -0,0 +1,220 @@
+#include "jvmtuner.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+#ifdef Q_OS_OSX
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+
+QStringList JvmTuner::makeArgs(int heapSize, int collector,
+                               const QStringList &userArgs,
+                               int javaWordSize, int javaVersion)
+{
+    bool hasUserHeap = false;
+    bool hasUserCollector = false;
+
+    foreach (const QString &arg, userArgs)
+    {
+        if ( arg.startsWith("-Xmx") || arg.startsWith("-Xms") )
+        {
+            hasUserHeap = true;
+        }
+
+        if ( arg.startsWith("-XX:+Use") && arg.endsWith("GC") )
+        {
+            hasUserCollector = true;
+        }
+    }
+
+    if (heapSize <= 0)
+    {
+        heapSize = getRecommendedHeapSize(javaWordSize);
+    }
+
+    QStringList args;
+
+    if (!hasUserHeap && heapSize > 0)
+    {
+        args << "-Xms" + QString::number(heapSize / 2) + "M"
+             << "-Xmx" + QString::number(heapSize) + "M";
+    }
+
+    // Several collectors can't be selected at once
+    if (!hasUserCollector)
+    {
+        args << makeCollectorArgs(collector, heapSize, javaVersion);
+    }
+
+    return args;
+}
+
+QStringList JvmTuner::makeCollectorArgs(int collector, int heapSize,
+                                        int javaVersion)
+{
+    int cores = QThread::idealThreadCount();
+
+    // JVM selects serial collector on small machines by itself
+    if (collector == CollectorAuto)
+    {
+        bool isSmall = cores <= 2 || (heapSize > 0 && heapSize < 1024);
+        collector = isSmall ? CollectorDefault : CollectorG1;
+    }
+
+    QStringList args;
+
+    if (collector == CollectorG1)
+    {
+        // One core is left for the game's render thread
+        int parallelThreads = qBound(1, cores - 1, 8);
+        int concurrentThreads = qMax(1, parallelThreads / 4);
+
+        args << "-XX:+UseG1GC"
+             << "-XX:MaxGCPauseMillis=" + QString::number(pauseTarget)
+             << "-XX:+ParallelRefProcEnabled"
+             << "-XX:ParallelGCThreads=" + QString::number(parallelThreads)
+             << "-XX:ConcGCThreads=" + QString::number(concurrentThreads);
+    }
+    else if (collector == CollectorZ)
+    {
+        // ZGC is unknown before Java 11, known runtimes without it
+        // never get here
+        if (javaVersion == 0)
+        {
+            args << "-XX:+IgnoreUnrecognizedVMOptions";
+        }
+
+        // ZGC is experimental before Java 15
+        if (javaVersion < 15)
+        {
+            args << "-XX:+UnlockExperimentalVMOptions";
+        }
+
+        args << "-XX:+UseZGC";
+    }
+
+    return args;
+}
+
+int JvmTuner::getRecommendedHeapSize(int javaWordSize)
+{
+    qint64 total = getTotalMemory();
+    if (total <= 0)
+    {
+        return 0;
+    }
+
+    qint64 heapSize;
+    if (total <= 4096)
+    {
+        heapSize = 1024;
+    }
+    else if (total <= 8192)
+    {
+        heapSize = 2048;
+    }
+    else if (total <= 16384)
+    {
+        heapSize = 4096;
+    }
+    else
+    {
+        heapSize = 6144;
+    }
+
+    // Leave memory to programs which are already running
+    qint64 available = getAvailableMemory();
+    if (available > 0)
+    {
+        qint64 limit = qMax<qint64>(minHeapSize, available * 3 / 4);
+        heapSize = qMin(heapSize, limit);
+    }
+
+    // Unknown runtime is supposed to match the launcher
+    if (javaWordSize == 0)
+    {
+        javaWordSize = QSysInfo::WordSize;
+    }
+
+    // 32-bit Java can't reserve much more than a gigabyte
+    if (javaWordSize == 32)
+    {
+        heapSize = qMin<qint64>(heapSize, 1024);
+    }
+
+    return qMax( minHeapSize, int(heapSize / 256 * 256) );
+}
+
+qint64 JvmTuner::getTotalMemory()
+{
+#ifdef Q_OS_LINUX
+    return readMemInfo("MemTotal");
+#elif defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+
+    if ( GlobalMemoryStatusEx(&status) )
+    {
+        return qint64(status.ullTotalPhys / (1024 * 1024));
+    }
+    return 0;
+#elif defined(Q_OS_OSX)
+    quint64 size = 0;
+    size_t length = sizeof(size);
+
+    if (sysctlbyname("hw.memsize", &size, &length, NULL, 0) == 0)
+    {
+        return qint64(size / (1024 * 1024));
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+qint64 JvmTuner::getAvailableMemory()
+{
+#ifdef Q_OS_LINUX
+    return readMemInfo("MemAvailable");
+#elif defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+
+    if ( GlobalMemoryStatusEx(&status) )
+    {
+        return qint64(status.ullAvailPhys / (1024 * 1024));
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+#ifdef Q_OS_LINUX
+qint64 JvmTuner::readMemInfo(const QString &key)
+{
+    QFile file("/proc/meminfo");
+    if ( !file.open(QIODevice::ReadOnly | QIODevice::Text) )
+    {
+        return 0;
+    }
+
+    // Lines look like "MemTotal:       16318016 kB"
+    QString prefix = key + ":";
+    QByteArray line;
+
+    while ( !(line = file.readLine()).isEmpty() )
+    {
+        QString text = QString::fromLatin1(line);
+        if ( text.startsWith(prefix) )
+        {
+            QString value = text.mid( prefix.length() ).trimmed();
+            return value.section(' ', 0, 0).toLongLong() / 1024;
+        }
+    }
+
+    return 0;
+}
+#endif
@@ -0,0 +1,44 @@
+#ifndef JVMTUNER_H
+#define JVMTUNER_H
+
+#include <QtCore>
+
+// Chooses Java heap size and garbage collector options for the game
+// from the amount of memory and processors of this computer
+class JvmTuner
+{
+public:
+    enum Collector
+    {
+        CollectorAuto,
+        CollectorG1,
+        CollectorZ,
+        CollectorDefault
+    };
+
+    // Heap size in megabytes, 0 selects it automatically. Options given
+    // by user in userArgs take precedence over the generated ones.
+    // Word size in bits and major version of the Java runtime, 0 if unknown
+    static QStringList makeArgs(int heapSize, int collector,
+                                const QStringList &userArgs,
+                                int javaWordSize = 0, int javaVersion = 0);
+
+    static int getRecommendedHeapSize(int javaWordSize = 0);
+
+    // Memory sizes in megabytes, 0 if unknown
+    static qint64 getTotalMemory();
+    static qint64 getAvailableMemory();
+
+private:
+    static const int minHeapSize = 512;
+    static const int pauseTarget = 50;
+
+    static QStringList makeCollectorArgs(int collector, int heapSize,
+                                         int javaVersion);
+
+#ifdef Q_OS_LINUX
+    static qint64 readMemInfo(const QString &key);
+#endif
+};
+
+#endif // JVMTUNER_H
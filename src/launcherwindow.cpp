@@ -15,6 +15,9 @@
 #include "settings.h"
 #include "util.h"
 #include "jsonparser.h"
+#include "launchpreparer.h"
+#include "bandwidthlimiter.h"
+#include "mirrorlist.h"
 
 #include <QtGui>
 #include <QDesktopWidget>
@@ -23,18 +26,34 @@
 
 #include <QDebug>
 
+// Log display limits
+static const int maxLogLines = 5000;
+static const int logUpdateInterval = 100;
+
 LauncherWindow::LauncherWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::LauncherWindow)
 {
     ui->setupUi(this);
 
+    // Resource usage panel is shown only while the game is running
+    ui->monitorLabel->hide();
+
     settings = Settings::instance();
     logger = Logger::logger();
 
+    gameRunning = false;
+    updateDialogOpen = false;
+
     // Show welcome message
     QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
     ui->logDisplay->setFont(font);
+    ui->logDisplay->setMaximumBlockCount(maxLogLines);
+
+    logTimer.setSingleShot(true);
+    logTimer.setInterval(logUpdateInterval);
+
+    connect(&logTimer, &QTimer::timeout, this, &LauncherWindow::flushLog);
 
     appendToLog( tr("Welcome to the ttyhlauncher.") );
 
@@ -87,6 +106,11 @@ LauncherWindow::LauncherWindow(QWidget *parent) :
     connect(ui->hideLauncher, &QAction::triggered, this,
             &LauncherWindow::hideWindowModeChanged);
 
+    ui->throttleDownloads->setChecked( settings->loadThrottleState() );
+
+    connect(ui->throttleDownloads, &QAction::triggered, this,
+            &LauncherWindow::throttleModeChanged);
+
     bool isLoadNews = settings->loadNewsState();
     ui->loadNews->setChecked(isLoadNews);
 
@@ -129,6 +153,9 @@ LauncherWindow::LauncherWindow(QWidget *parent) :
     connect( ui->clientCombo, SIGNAL( activated(int) ), settings,
              SLOT( saveActiveClientID(int) ) );
 
+    connect(settings, &Settings::localDataUpdated, this,
+            &LauncherWindow::clientListUpdated);
+
     // Setup window parameters
     QRect geometry = settings->loadWindowGeometry();
 
@@ -172,14 +199,22 @@ LauncherWindow::LauncherWindow(QWidget *parent) :
     }
 #endif
 
+    // Prepare the next launch while the launcher is idle
+    connect(this, &LauncherWindow::windowOpened, this,
+            &LauncherWindow::prepareLaunch);
+
+    connect(settings, &Settings::activeClientChanged, this,
+            &LauncherWindow::prepareLaunch);
+
+    // Prepared plan holds URLs of the mirror in use
+    connect(MirrorList::instance(), &MirrorList::serverChanged, this,
+            &LauncherWindow::prepareLaunch);
+
+    // Client list may arrive later from the update server
     if (ui->clientCombo->count() == 0)
     {
-        connect(this, &LauncherWindow::windowOpened, this, [=]()
-        {
-            ui->playButton->setEnabled(false);
-            showError(tr("No available clients!"), true);
-        },
-        Qt::QueuedConnection);
+        ui->playButton->setEnabled(false);
+        log( tr("Waiting for client list...") );
     }
 }
 
@@ -199,7 +234,7 @@ void LauncherWindow::closeEvent(QCloseEvent *event)
 
 void LauncherWindow::keyPressEvent(QKeyEvent *pe)
 {
-    if (pe->key() == Qt::Key_Return)
+    if ( pe->key() == Qt::Key_Return && ui->playButton->isEnabled() )
     {
         playButtonClicked();
     }
@@ -208,17 +243,41 @@ void LauncherWindow::keyPressEvent(QKeyEvent *pe)
 
 void LauncherWindow::appendToLog(const QString &text)
 {
-    QStringList lines = text.split("\n");
+    pendingLines << text.split("\n");
+
+    // Older lines would be dropped by the display anyway
+    int extra = pendingLines.count() - maxLogLines;
+    if (extra > 0)
+    {
+        pendingLines.erase( pendingLines.begin(),
+                            pendingLines.begin() + extra );
+    }
+
+    if ( !logTimer.isActive() )
+    {
+        logTimer.start();
+    }
+}
+
+void LauncherWindow::flushLog()
+{
+    ui->logDisplay->setUpdatesEnabled(false);
 
-    foreach (QString line, lines)
+    foreach (QString line, pendingLines)
     {
         appendLineToLog(line);
     }
+    pendingLines.clear();
+
+    ui->logDisplay->setUpdatesEnabled(true);
 }
 
 void LauncherWindow::appendLineToLog(const QString &line)
 {
-    QRegularExpression urlRegEx("(https?://[A-Za-z0-9\\.\\-\\?_=~#/]+)");
+    static const QRegularExpression urlRegEx(
+        "(https?://[A-Za-z0-9\\.\\-\\?_=~#/]+)",
+        QRegularExpression::OptimizeOnFirstUsageOption);
+
     QRegularExpressionMatch urlMatch = urlRegEx.match(line);
 
     if ( urlMatch.hasMatch() )
@@ -318,6 +377,7 @@ void LauncherWindow::showSettingsDialog()
     delete d;
 
     ui->clientCombo->setCurrentIndex( settings->loadActiveClientID() );
+    prepareLaunch();
 }
 
 void LauncherWindow::showSkinLoadDialog()
@@ -355,16 +415,24 @@ void LauncherWindow::showStoreSettingsDialog()
 
 void LauncherWindow::showStoreManageDialog()
 {
+    LaunchPreparer::instance()->cancel();
+
     StoreManageDialog *d = new StoreManageDialog(this);
     d->exec();
     delete d;
+
+    prepareLaunch();
 }
 
 void LauncherWindow::showStoreInstallDialog()
 {
+    LaunchPreparer::instance()->cancel();
+
     StoreInstallDialog *d = new StoreInstallDialog(this);
     d->exec();
     delete d;
+
+    prepareLaunch();
 }
 
 void LauncherWindow::offlineModeChanged()
@@ -387,6 +455,11 @@ void LauncherWindow::hideWindowModeChanged()
     settings->saveHideWindowModeState( ui->hideLauncher->isChecked() );
 }
 
+void LauncherWindow::throttleModeChanged()
+{
+    settings->saveThrottleState( ui->throttleDownloads->isChecked() );
+}
+
 void LauncherWindow::fetchNewsModeChanged()
 {
     settings->saveNewsState( ui->loadNews->isChecked() );
@@ -400,6 +473,36 @@ void LauncherWindow::newsFetched(bool result)
     }
 }
 
+void LauncherWindow::clientListUpdated(bool result)
+{
+    ui->clientCombo->clear();
+    ui->clientCombo->addItems( settings->getClientCaptions() );
+    ui->clientCombo->setCurrentIndex( settings->loadActiveClientID() );
+
+    if (ui->clientCombo->count() == 0)
+    {
+        ui->playButton->setEnabled(false);
+
+        if (result)
+        {
+            showError(tr("No available clients!"), true);
+        }
+        else
+        {
+            // Nothing is cached, so keep trying
+            log( tr("Error! Can't fetch client list, retrying later.") );
+            QTimer::singleShot(clientListRetryDelay, settings,
+                               &Settings::updateLocalData);
+        }
+        return;
+    }
+
+    ui->playButton->setEnabled(true);
+
+    // Active client may be a different one now
+    QTimer::singleShot(0, this, SLOT(prepareLaunch()));
+}
+
 void LauncherWindow::freezeInterface()
 {
     ui->runPanel->setEnabled(false);
@@ -410,15 +513,57 @@ void LauncherWindow::unfreezeInterface()
 {
     ui->runPanel->setEnabled(true);
     ui->menuBar->setEnabled(true);
+
+    ui->runSettings->setEnabled(true);
+    ui->runStoreManage->setEnabled(true);
+    ui->runStoreInstall->setEnabled(true);
+
+    prepareLaunch();
+}
+
+void LauncherWindow::prepareLaunch()
+{
+    // Client files must not be touched while the game is running
+    if ( ui->runPanel->isEnabled() && ui->playButton->isEnabled() )
+    {
+        LaunchPreparer::instance()->schedule();
+    }
 }
 
 void LauncherWindow::showUpdateDialog(QString message)
 {
+    // Preparation must not read files which are being updated
+    LaunchPreparer::instance()->cancel();
+
     UpdateDialog *d = new UpdateDialog(message, this);
+    d->setDeferredApply(gameRunning);
+
+    updateDialogOpen = true;
     d->exec();
+    updateDialogOpen = false;
+
     delete d;
 
+    // Game may have exited while the dialog was open
+    if (!gameRunning)
+    {
+        applyPendingUpdate();
+    }
+
     ui->clientCombo->setCurrentIndex( settings->loadActiveClientID() );
+    prepareLaunch();
+}
+
+void LauncherWindow::applyPendingUpdate()
+{
+    // Staged files would be removed under the open update dialog
+    if ( updateDialogOpen || !UpdateTransaction::hasPending() )
+    {
+        return;
+    }
+
+    log( tr("Applying the update downloaded during the game...") );
+    UpdateTransaction::recover();
 }
 
 void LauncherWindow::playButtonClicked()
@@ -433,6 +578,9 @@ void LauncherWindow::playButtonClicked()
     bool isOnline = !ui->playOffline->isChecked();
     QRect geometry = this->geometry();
 
+    // Wait for background preparation, it may be extracting natives
+    LaunchPreparer::instance()->cancel();
+
     gameRunner = new GameRunner(login, pass, isOnline, geometry);
 
     connect(gameRunner, &GameRunner::error, this,
@@ -447,12 +595,40 @@ void LauncherWindow::playButtonClicked()
     connect(gameRunner, &GameRunner::finished, this,
             &LauncherWindow::gameRunnerFinished);
 
+    connect(gameRunner, &GameRunner::statsChanged, this,
+            &LauncherWindow::gameRunnerStatsChanged);
+
+    connect(gameRunner, &GameRunner::crashReported, this,
+            &LauncherWindow::gameRunnerCrashReported);
+
+    crashReport.clear();
+    crashReason.clear();
+
     freezeInterface();
     gameRunner->Run();
 }
 
 void LauncherWindow::gameRunnerStarted()
 {
+    ui->monitorLabel->clear();
+    ui->monitorLabel->show();
+
+    // Next update may be downloaded during the game, but dialogs which
+    // change client files directly stay closed
+    gameRunning = true;
+
+    ui->menuBar->setEnabled(true);
+    ui->runSettings->setEnabled(false);
+    ui->runStoreManage->setEnabled(false);
+    ui->runStoreInstall->setEnabled(false);
+
+    // Downloads must not cause lag spikes in the game
+    if ( settings->loadThrottleState() )
+    {
+        int rate = settings->loadThrottleRate();
+        BandwidthLimiter::instance()->setLimit(rate);
+    }
+
     if ( ui->hideLauncher->isChecked() )
     {
         this->hide();
@@ -463,6 +639,12 @@ void LauncherWindow::gameRunnerStarted()
 void LauncherWindow::gameRunnerError(const QString &message)
 {
     gameRunner->deleteLater();
+    ui->monitorLabel->hide();
+
+    gameRunning = false;
+    applyPendingUpdate();
+
+    BandwidthLimiter::instance()->setLimit(0);
     unfreezeInterface();
     showError(message, false);
 }
@@ -477,6 +659,12 @@ void LauncherWindow::gameRunnerNeedUpdate(const QString &message)
 void LauncherWindow::gameRunnerFinished(int exitCode)
 {
     gameRunner->deleteLater();
+    ui->monitorLabel->hide();
+
+    gameRunning = false;
+    applyPendingUpdate();
+
+    BandwidthLimiter::instance()->setLimit(0);
 
     if ( this->isHidden() )
     {
@@ -486,12 +674,44 @@ void LauncherWindow::gameRunnerFinished(int exitCode)
 
     unfreezeInterface();
 
-    if (exitCode != 0)
+    if ( !crashReport.isEmpty() )
+    {
+        // Offer to send the report while it is fresh
+        QString message = tr("The game has crashed: %1\n\n"
+                             "Report: %2\n\n"
+                             "Send diagnostic log to the developers?");
+
+        QString reason = crashReason.isEmpty() ? tr("unknown reason")
+                                               : crashReason;
+
+        log( tr("Game crashed, report: %1").arg(crashReport) );
+
+        QMessageBox::StandardButton answer = QMessageBox::question(
+            this, tr("Game crashed"), message.arg(reason, crashReport) );
+
+        if (answer == QMessageBox::Yes)
+        {
+            showFeedBackDialog();
+        }
+    }
+    else if (exitCode != 0)
     {
         showError(tr("Process finished incorrectly!"), true);
     }
 }
 
+void LauncherWindow::gameRunnerCrashReported(const QString &path,
+                                             const QString &reason)
+{
+    crashReport = path;
+    crashReason = reason;
+}
+
+void LauncherWindow::gameRunnerStatsChanged(const QString &stats)
+{
+    ui->monitorLabel->setText(stats);
+}
+
 LauncherWindow::~LauncherWindow()
 {
     delete ui;
@@ -31,6 +31,7 @@ signals:
 
 private slots:
     void appendToLog(const QString &text);
+    void flushLog();
     QString escapeString(const QString &string);
 
     void showSettingsDialog();
@@ -46,17 +47,23 @@ private slots:
     void offlineModeChanged();
     void hideWindowModeChanged();
     void fetchNewsModeChanged();
+    void throttleModeChanged();
 
     void newsFetched(bool result);
+    void clientListUpdated(bool result);
 
     void freezeInterface();
     void unfreezeInterface();
 
+    void prepareLaunch();
+
     void playButtonClicked();
     void gameRunnerError(const QString &message);
     void gameRunnerNeedUpdate(const QString &message);
     void gameRunnerStarted();
     void gameRunnerFinished(int exitCode);
+    void gameRunnerStatsChanged(const QString &stats);
+    void gameRunnerCrashReported(const QString &path, const QString &reason);
 
     void showError(const QString &message, bool showInLog);
 
@@ -70,6 +77,20 @@ private:
     DataFetcher newsFetcher;
     GameRunner *gameRunner;
 
+    // Updates are downloaded during the game, but applied after it
+    bool gameRunning;
+    bool updateDialogOpen;
+
+    // Last crash report of the running game
+    QString crashReport;
+    QString crashReason;
+
+    static const int clientListRetryDelay = 30000;
+
+    // Lines waiting for the next log display update
+    QStringList pendingLines;
+    QTimer logTimer;
+
     void log(const QString &line);
 
     void appendLineToLog(const QString &line);
@@ -77,6 +98,7 @@ private:
     void storeParameters();
 
     void showUpdateDialog(const QString message);
+    void applyPendingUpdate();
 };
 
 #endif // LAUNCHERWINDOW_H
@@ -0,0 +1,884 @@
+#include "launchpreparer.h"
+
+#include <quazip5/quazip.h>
+#include <quazip5/quazipfile.h>
+
+#include "settings.h"
+#include "logger.h"
+#include "jsonparser.h"
+#include "hashchecker.h"
+#include "installmanifest.h"
+#include "localversions.h"
+#include "javaregistry.h"
+#include "util.h"
+
+// Prepares one launch plan in the preparer's thread pool
+class PrepareTask : public QRunnable
+{
+public:
+    PrepareTask(LaunchPreparer *launchPreparer,
+                const LaunchEnvironment &launchEnvironment,
+                int planGeneration)
+    {
+        preparer = launchPreparer;
+        environment = launchEnvironment;
+        generation = planGeneration;
+    }
+
+    void run()
+    {
+        preparer->prepare(environment, generation);
+    }
+
+private:
+    LaunchPreparer *preparer;
+    LaunchEnvironment environment;
+    int generation;
+};
+
+LaunchEnvironment LaunchEnvironment::current(const QString &version)
+{
+    Settings *settings = Settings::instance();
+    LaunchEnvironment environment;
+
+    int active = settings->loadActiveClientID();
+    environment.client = settings->getClientName(active);
+    environment.version = version;
+
+    environment.clientUrl = settings->getClientUrl();
+    environment.clientDir = settings->getClientDir();
+    environment.versionsDir = settings->getVersionsDir();
+    environment.libsDir = settings->getLibsDir();
+    environment.libsUrl = settings->getLibsUrl();
+    environment.assetsDir = settings->getAssetsDir();
+    environment.assetsUrl = settings->getAssetsUrl();
+    environment.nativesDir = settings->getNativesDir();
+
+    environment.checkAssets = settings->loadClientCheckAssetsState();
+    environment.isWindows = settings->getOsName() == "windows";
+
+    return environment;
+}
+
+bool LaunchEnvironment::isSameClient(const LaunchEnvironment &other) const
+{
+    return client == other.client
+           && clientUrl == other.clientUrl
+           && clientDir == other.clientDir
+           && versionsDir == other.versionsDir
+           && libsDir == other.libsDir
+           && libsUrl == other.libsUrl
+           && assetsDir == other.assetsDir
+           && assetsUrl == other.assetsUrl
+           && nativesDir == other.nativesDir
+           && checkAssets == other.checkAssets
+           && isWindows == other.isWindows;
+}
+
+LaunchPreparer *LaunchPreparer::myInstance = NULL;
+LaunchPreparer *LaunchPreparer::instance()
+{
+    if (myInstance == NULL)
+    {
+        myInstance = new LaunchPreparer();
+    }
+    return myInstance;
+}
+
+LaunchPreparer::LaunchPreparer(QObject *parent) : QObject(parent)
+{
+    hasPlan = false;
+
+    // One task at a time, so natives are never extracted concurrently
+    pool.setMaxThreadCount(1);
+
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(idleDelay);
+
+    connect(&idleTimer, &QTimer::timeout, this, &LaunchPreparer::start);
+}
+
+void LaunchPreparer::schedule()
+{
+    // Running preparation is outdated now
+    generation.ref();
+    idleTimer.start();
+}
+
+void LaunchPreparer::cancel()
+{
+    idleTimer.stop();
+    generation.ref();
+    pool.waitForDone();
+}
+
+void LaunchPreparer::start()
+{
+    QString version = Settings::instance()->loadClientVersion();
+    LaunchEnvironment environment = LaunchEnvironment::current(version);
+
+    planMutex.lock();
+    hasPlan = false;
+    planMutex.unlock();
+
+    // Runtimes are rescanned while the launcher is idle too
+    Settings *settings = Settings::instance();
+
+    QStringList javaPaths;
+    if ( settings->loadClientJavaState() )
+    {
+        javaPaths << settings->loadClientJava();
+    }
+    JavaRegistry::instance()->refresh(javaPaths);
+
+    int planGeneration = generation.load();
+    pool.start( new PrepareTask(this, environment, planGeneration) );
+}
+
+bool LaunchPreparer::takePlan(const LaunchEnvironment &environment,
+                              LaunchPlan *plan)
+{
+    QMutexLocker locker(&planMutex);
+
+    if ( !hasPlan || preparedPlan.version != environment.version )
+    {
+        return false;
+    }
+
+    if ( !preparedPlan.environment.isSameClient(environment) )
+    {
+        return false;
+    }
+
+    // Indexes may be replaced by an update after preparation
+    if ( makeIndexStamp(preparedPlan) != preparedPlan.indexStamp )
+    {
+        return false;
+    }
+
+    *plan = preparedPlan;
+    return true;
+}
+
+bool LaunchPreparer::isCancelled(int planGeneration) const
+{
+    return generation.load() != planGeneration;
+}
+
+void LaunchPreparer::prepare(const LaunchEnvironment &environment,
+                             int planGeneration)
+{
+    if ( isCancelled(planGeneration) )
+    {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    LaunchPlan plan;
+    QString error;
+
+    if ( !makePlan(environment, &plan, &error) )
+    {
+        log( tr("Launch is not prepared: %1").arg(error) );
+        return;
+    }
+
+    // Hash files unknown to the install manifest, so the check before
+    // launch only has to compare sizes and modification times
+    InstallManifest *manifest = InstallManifest::instance();
+
+    foreach (const FileInfo entry, plan.checkList)
+    {
+        if ( isCancelled(planGeneration) )
+        {
+            manifest->save();
+            return;
+        }
+
+        if ( entry.isMutable || manifest->isFileValid(entry.name, entry.hash) )
+        {
+            continue;
+        }
+
+        if ( HashChecker::isFileHashValid(entry.name, entry.hash) )
+        {
+            manifest->update(entry.name, entry.hash);
+        }
+    }
+
+    manifest->save();
+
+    if ( isCancelled(planGeneration) )
+    {
+        return;
+    }
+
+    if ( !prepareNatives(plan) )
+    {
+        log( tr("Launch is not prepared: can't extract natives.") );
+        return;
+    }
+
+    QMutexLocker locker(&planMutex);
+
+    if ( isCancelled(planGeneration) )
+    {
+        return;
+    }
+
+    preparedPlan = plan;
+    hasPlan = true;
+
+    QString message = tr("Launch of %1 prepared in %2 ms.");
+    log( message.arg(plan.version).arg( timer.elapsed() ) );
+}
+
+bool LaunchPreparer::makePlan(const LaunchEnvironment &environment,
+                              LaunchPlan *plan, QString *error)
+{
+    plan->environment = environment;
+    plan->version = environment.version;
+
+    if (plan->version == "latest")
+    {
+        plan->version = LocalVersions::findLatest(environment.versionsDir);
+
+        if ( plan->version.isEmpty() )
+        {
+            *error = tr("Local versions not found.");
+            return false;
+        }
+    }
+
+    QString version = plan->version;
+    QString versionDir = environment.versionsDir + "/" + version + "/";
+    QString versionUrl = environment.clientUrl + version + "/";
+
+    QByteArray versionIndex = readIndex(versionDir + version + ".json");
+    QByteArray dataIndex = readIndex(versionDir + "data.json");
+
+    // Run data is taken from compiled plan while indexes are unchanged
+    QString planPath = versionDir + "launch_plan.json";
+    QString planKey = makePlanKey(*plan, versionIndex, dataIndex);
+    bool isCompiled = loadCompiledPlan(planPath, planKey, plan);
+
+    if (!isCompiled && !compilePlan(versionIndex, plan, error) )
+    {
+        return false;
+    }
+
+    JsonParser dataParser, assetsParser;
+
+    if ( !dataParser.setJson(dataIndex) )
+    {
+        QString message = tr("Can't parse data index! %1");
+        *error = message.arg( dataParser.getParserError() );
+        return false;
+    }
+
+    // Main JAR
+    if ( !dataParser.hasJarFileInfo() )
+    {
+        *error = tr("Main JAR does not described in data index.");
+        return false;
+    }
+
+    FileInfo jar;
+
+    jar.name = versionDir + version + ".jar";
+    jar.hash = dataParser.getJarFileInfo().hash;
+    jar.size = dataParser.getJarFileInfo().size;
+    jar.url = versionUrl + version + ".jar";
+
+    plan->checkList.append(jar);
+
+    // Libraries
+    QString libDir = environment.libsDir + "/";
+
+    foreach (LibraryInfo entry, plan->libraries)
+    {
+        QString lib = entry.name;
+
+        if ( !dataParser.hasLibFileInfo(lib) )
+        {
+            *error = tr("Data index not contains library: %1").arg(lib);
+            return false;
+        }
+
+        FileInfo fileInfo = dataParser.getLibFileInfo(lib);
+
+        fileInfo.name = libDir + lib;
+        fileInfo.url = environment.libsUrl + lib;
+
+        plan->checkList.append(fileInfo);
+    }
+
+    // Addons
+    if ( !dataParser.hasAddonsFilesInfo() )
+    {
+        *error = tr("Addons are not described in data index.");
+        return false;
+    }
+
+    QString clientPrefix = environment.clientDir + "/prefixes/" + version;
+    QString addonsUrl = versionUrl + "files/";
+
+    QList<FileInfo> addons = dataParser.getAddonsFilesInfo();
+    foreach (FileInfo addon, addons)
+    {
+        QString shortName = addon.name;
+        addon.name = clientPrefix + "/" + shortName;
+        addon.url = addonsUrl + shortName;
+
+        plan->checkList.append(addon);
+    }
+
+    // Assets
+    if (environment.checkAssets)
+    {
+        QString assetsIndexDir = environment.assetsDir + "/indexes/";
+        QString assetsName = plan->assetsName + ".json";
+
+        if ( !assetsParser.setJsonFromFile(assetsIndexDir + assetsName) )
+        {
+            QString message = tr("Can't parse assets index: ");
+            *error = message + assetsParser.getParserError();
+            return false;
+        }
+
+        if ( !assetsParser.hasAssetsList() )
+        {
+            *error = tr("Assets list are not described in index.");
+            return false;
+        }
+
+        QString assetsDir = environment.assetsDir + "/objects/";
+        QString assetsUrl = environment.assetsUrl + "objects/";
+
+        QList<FileInfo> assets = assetsParser.getAssetsList();
+        foreach (FileInfo asset, assets)
+        {
+            QString shortName = asset.name;
+            asset.name = assetsDir + shortName;
+            asset.url = assetsUrl + shortName;
+
+            plan->checkList.append(asset);
+        }
+    }
+
+    if (!isCompiled)
+    {
+        saveCompiledPlan(planPath, planKey, *plan);
+    }
+
+    plan->indexStamp = makeIndexStamp(*plan);
+    return true;
+}
+
+bool LaunchPreparer::compilePlan(const QByteArray &versionIndex,
+                                 LaunchPlan *plan, QString *error)
+{
+    const LaunchEnvironment &environment = plan->environment;
+    QString version = plan->version;
+
+    JsonParser versionParser;
+
+    if ( !versionParser.setJson(versionIndex) )
+    {
+        QString message = tr("Can't parse version index! %1");
+        *error = message.arg( versionParser.getParserError() );
+        return false;
+    }
+
+    if ( !versionParser.hasLibraryList() )
+    {
+        *error = tr("Libraries are not described in data index.");
+        return false;
+    }
+
+    if ( !versionParser.hasMainClass() )
+    {
+        *error = tr("No main class in %1.json!").arg(version);
+        return false;
+    }
+
+    if ( !versionParser.hasAssetsVersion() )
+    {
+        *error = tr("No assets in %1.json!").arg(version);
+        return false;
+    }
+
+    if ( !versionParser.hasMinecraftArgs() )
+    {
+        *error = tr("No minecraft args in %1.json!").arg(version);
+        return false;
+    }
+
+    plan->libraries = versionParser.getLibraryList();
+    plan->mainClass = versionParser.getMainClass();
+    plan->assetsName = versionParser.getAssetsVesrsion();
+
+    plan->javaVersion = 0;
+    if ( versionParser.hasJavaVersion() )
+    {
+        plan->javaVersion = versionParser.getJavaVersion();
+    }
+
+    // Classpath
+    QString libDir = environment.libsDir + "/";
+    QString cpSep = environment.isWindows ? ";" : ":";
+
+    foreach (LibraryInfo entry, plan->libraries)
+    {
+        if (!entry.isNative)
+        {
+            plan->classpath += libDir + entry.name + cpSep;
+        }
+    }
+
+    QString versionDir = environment.versionsDir + "/" + version + "/";
+    plan->classpath += versionDir + version + ".jar";
+
+    // Game arguments, only login placeholders are left for launch time
+    QString clientPrefix = environment.clientDir + "/prefixes/" + version;
+
+    QString minecraftArgs = versionParser.getMinecraftArgs();
+    foreach ( QString arg, minecraftArgs.split(" ") )
+    {
+        arg.replace("${version_name}", version);
+        arg.replace("${game_directory}", clientPrefix);
+        arg.replace("${assets_root}", environment.assetsDir);
+        arg.replace("${assets_index_name}", plan->assetsName);
+        arg.replace("${user_properties}", "{}");
+        arg.replace("${user_type}", "mojang");
+        arg.replace("${version_type}", environment.client);
+
+        if ( arg.contains("${auth_") )
+        {
+            plan->loginArgs << plan->gameArgs.count();
+        }
+
+        plan->gameArgs << arg;
+    }
+
+    return true;
+}
+
+bool LaunchPreparer::loadCompiledPlan(const QString &path,
+                                      const QString &key, LaunchPlan *plan)
+{
+    QFile file(path);
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return false;
+    }
+
+    QJsonDocument json = QJsonDocument::fromJson( file.readAll() );
+    file.close();
+
+    QJsonObject root = json.object();
+    if ( root["key"].toString() != key )
+    {
+        return false;
+    }
+
+    foreach ( QJsonValue value, root["libraries"].toArray() )
+    {
+        QJsonObject library = value.toObject();
+
+        QString name = library["name"].toString();
+        bool isNative = library["native"].toBool();
+
+        plan->libraries << LibraryInfo(name, isNative);
+    }
+
+    plan->classpath = root["classpath"].toString();
+    plan->mainClass = root["mainClass"].toString();
+    plan->assetsName = root["assetsName"].toString();
+    plan->javaVersion = root["javaVersion"].toInt();
+
+    foreach ( QJsonValue value, root["gameArgs"].toArray() )
+    {
+        plan->gameArgs << value.toString();
+    }
+
+    foreach ( QJsonValue value, root["loginArgs"].toArray() )
+    {
+        plan->loginArgs << value.toInt();
+    }
+
+    return true;
+}
+
+void LaunchPreparer::saveCompiledPlan(const QString &path,
+                                      const QString &key,
+                                      const LaunchPlan &plan)
+{
+    QJsonArray libraries;
+    foreach (LibraryInfo libInfo, plan.libraries)
+    {
+        QJsonObject library;
+        library["name"] = libInfo.name;
+        library["native"] = libInfo.isNative;
+
+        libraries.append(library);
+    }
+
+    QJsonArray loginArgs;
+    foreach (int index, plan.loginArgs)
+    {
+        loginArgs.append(index);
+    }
+
+    QJsonObject root;
+    root["key"] = key;
+    root["libraries"] = libraries;
+    root["classpath"] = plan.classpath;
+    root["mainClass"] = plan.mainClass;
+    root["assetsName"] = plan.assetsName;
+    root["javaVersion"] = plan.javaVersion;
+    root["gameArgs"] = QJsonArray::fromStringList(plan.gameArgs);
+    root["loginArgs"] = loginArgs;
+
+    QSaveFile file(path);
+    if ( file.open(QIODevice::WriteOnly) )
+    {
+        file.write( QJsonDocument(root).toJson(QJsonDocument::Compact) );
+        file.commit();
+    }
+}
+
+QString LaunchPreparer::makePlanKey(const LaunchPlan &plan,
+                                    const QByteArray &versionIndex,
+                                    const QByteArray &dataIndex)
+{
+    const LaunchEnvironment &environment = plan.environment;
+
+    // Compiled plan contains absolute paths and the client name
+    QStringList values;
+    values << QString::number(compiledPlanFormat)
+           << environment.client
+           << environment.clientDir
+           << environment.versionsDir
+           << environment.libsDir
+           << environment.assetsDir
+           << (environment.isWindows ? "windows" : "unix");
+
+    QCryptographicHash sha(QCryptographicHash::Sha1);
+    sha.addData( values.join("\n").toUtf8() );
+    sha.addData(versionIndex);
+    sha.addData(dataIndex);
+
+    return QString( sha.result().toHex() );
+}
+
+QByteArray LaunchPreparer::readIndex(const QString &path)
+{
+    QByteArray data;
+
+    QFile file(path);
+    if ( file.open(QIODevice::ReadOnly) )
+    {
+        data = file.readAll();
+        file.close();
+    }
+
+    return data;
+}
+
+QStringList LaunchPlan::makeGameArgs(const QString &playerName,
+                                     const QString &uuid,
+                                     const QString &accessToken) const
+{
+    QStringList args = gameArgs;
+
+    foreach (int index, loginArgs)
+    {
+        QString &arg = args[index];
+
+        arg.replace("${auth_player_name}", playerName);
+        arg.replace("${auth_uuid}", uuid);
+        arg.replace("${auth_access_token}", accessToken);
+    }
+
+    return args;
+}
+
+bool LaunchPreparer::prepareNatives(const LaunchPlan &plan)
+{
+    QString nativesPath = plan.environment.nativesDir;
+    QString stamp = makeNativesStamp(plan);
+
+    // Natives are extracted again only if native libraries are changed
+    QFile stampFile(nativesPath + "/.stamp");
+
+    if ( stampFile.open(QIODevice::ReadOnly) )
+    {
+        bool isActual = QString::fromUtf8( stampFile.readAll() ) == stamp;
+        stampFile.close();
+
+        if (isActual)
+        {
+            return true;
+        }
+    }
+
+    Util::removeAll(nativesPath);
+
+    QDir libsDir = QDir(nativesPath);
+    libsDir.mkpath(nativesPath);
+
+    if ( !libsDir.exists() )
+    {
+        return false;
+    }
+
+    QString libDir = plan.environment.libsDir + "/";
+
+    foreach (LibraryInfo libInfo, plan.libraries)
+    {
+        if (libInfo.isNative)
+        {
+            Util::unzipArchive(libDir + libInfo.name, nativesPath);
+        }
+    }
+
+    // Stamp is written last, so interrupted extraction will be repeated
+    if ( stampFile.open(QIODevice::WriteOnly) )
+    {
+        stampFile.write( stamp.toUtf8() );
+        stampFile.close();
+    }
+
+    return true;
+}
+
+QString LaunchPreparer::prepareClasspathJar(const LaunchPlan &plan)
+{
+    QString cpSep = plan.environment.isWindows ? ";" : ":";
+
+    // Class-Path holds space separated URLs, absolute ones are allowed
+    QStringList urls;
+    foreach ( QString entry, plan.classpath.split(cpSep) )
+    {
+        QString path = QFileInfo(entry).absoluteFilePath();
+        urls << QString::fromLatin1( QUrl::fromLocalFile(path).toEncoded() );
+    }
+
+    QByteArray classPath = "Class-Path: " + urls.join(' ').toLatin1();
+
+    QByteArray manifest;
+    manifest += "Manifest-Version: 1.0\r\n";
+    manifest += wrapManifestLine(classPath);
+    manifest += "Created-By: ttyhlauncher\r\n\r\n";
+
+    QString path = makeLaunchFilePath(plan, "classpath-", ".jar", manifest);
+    if ( QFile::exists(path) )
+    {
+        return path;
+    }
+
+    QBuffer buffer;
+    QuaZip zip(&buffer);
+
+    if ( !zip.open(QuaZip::mdCreate) )
+    {
+        return "";
+    }
+
+    QuaZipFile file(&zip);
+    QuaZipNewInfo info("META-INF/MANIFEST.MF");
+
+    if ( file.open(QIODevice::WriteOnly, info) )
+    {
+        file.write(manifest);
+        file.close();
+    }
+
+    zip.close();
+
+    if ( zip.getZipError() != ZIP_OK || file.getZipError() != ZIP_OK )
+    {
+        return "";
+    }
+
+    if ( !saveLaunchFile(path, "classpath-", ".jar", buffer.data()) )
+    {
+        return "";
+    }
+
+    return path;
+}
+
+QString LaunchPreparer::prepareArgFile(const LaunchPlan &plan,
+                                       const QStringList &args)
+{
+    // Every argument is quoted, so quotes and backslashes are escaped
+    QStringList lines;
+    foreach (QString arg, args)
+    {
+        arg.replace("\\", "\\\\");
+        arg.replace("\"", "\\\"");
+
+        lines << "\"" + arg + "\"";
+    }
+
+    QByteArray data = lines.join("\n").toLocal8Bit() + "\n";
+
+    QString path = makeLaunchFilePath(plan, "arguments-", ".txt", data);
+    if ( QFile::exists(path) )
+    {
+        return path;
+    }
+
+    if ( !saveLaunchFile(path, "arguments-", ".txt", data) )
+    {
+        return "";
+    }
+
+    return path;
+}
+
+QString LaunchPreparer::makeLaunchFilePath(const LaunchPlan &plan,
+                                           const QString &prefix,
+                                           const QString &suffix,
+                                           const QByteArray &source)
+{
+    QString versionDir = plan.environment.versionsDir + "/"
+                         + plan.version + "/";
+
+    // Name depends on contents, so changed files get new names
+    QString hash = HashChecker::getDataHash(source).left(12);
+    return versionDir + prefix + hash + suffix;
+}
+
+QString LaunchPreparer::makeCdsArchivePath(const LaunchPlan &plan,
+                                           const QString &java)
+{
+    QString cpSep = plan.environment.isWindows ? ";" : ":";
+
+    // JVM rejects the archive if any JAR is changed, so the name
+    // depends on JAR sizes and modification times too
+    QStringList source;
+    source << java;
+
+    foreach ( QString entry, plan.classpath.split(cpSep) )
+    {
+        QFileInfo info(entry);
+        qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+        source << entry + " " + QString::number( info.size() )
+                  + " " + QString::number(mtime);
+    }
+
+    QByteArray data = source.join("\n").toUtf8();
+    return makeLaunchFilePath(plan, "classes-", ".jsa", data);
+}
+
+void LaunchPreparer::removeOutdatedFiles(const QString &path,
+                                         const QString &prefix,
+                                         const QString &suffix)
+{
+    QFileInfo info(path);
+    QDir dir = info.absoluteDir();
+
+    QStringList filters;
+    filters << prefix + "*" + suffix;
+
+    foreach ( QString name, dir.entryList(filters, QDir::Files) )
+    {
+        if ( name != info.fileName() )
+        {
+            dir.remove(name);
+        }
+    }
+}
+
+bool LaunchPreparer::saveLaunchFile(const QString &path,
+                                    const QString &prefix,
+                                    const QString &suffix,
+                                    const QByteArray &data)
+{
+    // Outdated files of the same kind are not needed anymore
+    removeOutdatedFiles(path, prefix, suffix);
+
+    QSaveFile file(path);
+    if ( !file.open(QIODevice::WriteOnly) )
+    {
+        return false;
+    }
+
+    file.write(data);
+    return file.commit();
+}
+
+QByteArray LaunchPreparer::wrapManifestLine(const QByteArray &line)
+{
+    // Manifest lines are limited to 72 bytes, continuations begin
+    // with a single space
+    QByteArray result;
+
+    int pos = 0;
+    int width = 72;
+
+    while (line.size() - pos > width)
+    {
+        result += line.mid(pos, width) + "\r\n ";
+        pos += width;
+        width = 71;
+    }
+
+    result += line.mid(pos) + "\r\n";
+    return result;
+}
+
+QString LaunchPreparer::makeIndexStamp(const LaunchPlan &plan)
+{
+    QString versionDir = plan.environment.versionsDir + "/"
+                         + plan.version + "/";
+    QString assetsDir = plan.environment.assetsDir + "/indexes/";
+
+    QStringList indexes;
+    indexes << versionDir + plan.version + ".json"
+            << versionDir + "data.json"
+            << assetsDir + plan.assetsName + ".json";
+
+    QStringList stamp;
+    foreach (const QString &path, indexes)
+    {
+        QFileInfo info(path);
+        qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+        stamp << QString::number( info.size() ) + ":"
+                 + QString::number(mtime);
+    }
+
+    return stamp.join(";");
+}
+
+QString LaunchPreparer::makeNativesStamp(const LaunchPlan &plan)
+{
+    QString libDir = plan.environment.libsDir + "/";
+    QStringList stamp;
+
+    foreach (LibraryInfo libInfo, plan.libraries)
+    {
+        if (libInfo.isNative)
+        {
+            QFileInfo info(libDir + libInfo.name);
+            qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+            stamp << libInfo.name + " " + QString::number( info.size() )
+                     + " " + QString::number(mtime);
+        }
+    }
+
+    return stamp.join("\n");
+}
+
+void LaunchPreparer::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("LaunchPreparer"), text);
+}
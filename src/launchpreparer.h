@@ -0,0 +1,160 @@
+#ifndef LAUNCHPREPARER_H
+#define LAUNCHPREPARER_H
+
+#include <QtCore>
+
+#include "fileinfo.h"
+#include "libraryinfo.h"
+
+// Client paths and options which affect the launch of a version
+struct LaunchEnvironment
+{
+    QString client;
+    QString version;
+
+    QString clientUrl;
+    QString clientDir;
+    QString versionsDir;
+    QString libsDir;
+    QString libsUrl;
+    QString assetsDir;
+    QString assetsUrl;
+    QString nativesDir;
+
+    bool checkAssets;
+    bool isWindows;
+
+    // Reads active client settings, must be called from the main thread
+    static LaunchEnvironment current(const QString &version);
+
+    // Compares everything except the version
+    bool isSameClient(const LaunchEnvironment &other) const;
+};
+
+// Everything needed to start a client version, except login data
+struct LaunchPlan
+{
+    LaunchEnvironment environment;
+    QString version;
+    QString indexStamp;
+
+    QList<FileInfo> checkList;
+    QList<LibraryInfo> libraries;
+
+    QString classpath;
+    QString mainClass;
+    QString assetsName;
+
+    // Major Java version required by the index, 0 if not specified
+    int javaVersion;
+
+    // Game arguments with only login placeholders left unresolved
+    QStringList gameArgs;
+    QList<int> loginArgs;
+
+    QStringList makeGameArgs(const QString &playerName, const QString &uuid,
+                             const QString &accessToken) const;
+};
+
+// Prepares the next launch of the active client while the launcher is idle:
+// parses indexes, hashes client files into the install manifest and
+// extracts natives, so the game can be started without waiting for it
+class LaunchPreparer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LaunchPreparer *instance();
+
+    // Ways to pass the classpath to Java. Classpath JAR hides libraries
+    // from LaunchWrapper on Java 8 and argument files need Java 9,
+    // so by default the JAR is used only for too long command lines
+    enum ClasspathMode
+    {
+        ClasspathAuto,
+        ClasspathCommandLine,
+        ClasspathJar,
+        ClasspathArgFile
+    };
+
+    // Returns prepared plan if it is still actual for given environment
+    bool takePlan(const LaunchEnvironment &environment, LaunchPlan *plan);
+
+    static bool makePlan(const LaunchEnvironment &environment,
+                         LaunchPlan *plan, QString *error);
+
+    static bool prepareNatives(const LaunchPlan &plan);
+
+    // Return path to generated file or empty string on error
+    static QString prepareClasspathJar(const LaunchPlan &plan);
+    static QString prepareArgFile(const LaunchPlan &plan,
+                                  const QStringList &args);
+
+    // Class data sharing archive for given Java and classpath
+    static QString makeCdsArchivePath(const LaunchPlan &plan,
+                                      const QString &java);
+
+    static void removeOutdatedFiles(const QString &path,
+                                    const QString &prefix,
+                                    const QString &suffix);
+
+public slots:
+    void schedule();
+    void cancel();
+
+private:
+    explicit LaunchPreparer(QObject *parent = 0);
+
+    static LaunchPreparer *myInstance;
+
+    static const int idleDelay = 1000;
+    static const int compiledPlanFormat = 2;
+
+    QThreadPool pool;
+    QTimer idleTimer;
+    QAtomicInt generation;
+
+    QMutex planMutex;
+    LaunchPlan preparedPlan;
+    bool hasPlan;
+
+    void prepare(const LaunchEnvironment &environment, int planGeneration);
+    bool isCancelled(int planGeneration) const;
+
+    static bool compilePlan(const QByteArray &versionIndex,
+                            LaunchPlan *plan, QString *error);
+
+    static bool loadCompiledPlan(const QString &path, const QString &key,
+                                 LaunchPlan *plan);
+    static void saveCompiledPlan(const QString &path, const QString &key,
+                                 const LaunchPlan &plan);
+
+    static QString makePlanKey(const LaunchPlan &plan,
+                               const QByteArray &versionIndex,
+                               const QByteArray &dataIndex);
+    static QByteArray readIndex(const QString &path);
+
+    static QString makeLaunchFilePath(const LaunchPlan &plan,
+                                      const QString &prefix,
+                                      const QString &suffix,
+                                      const QByteArray &source);
+    static bool saveLaunchFile(const QString &path, const QString &prefix,
+                               const QString &suffix,
+                               const QByteArray &data);
+    static QByteArray wrapManifestLine(const QByteArray &line);
+
+    static QString makeIndexStamp(const LaunchPlan &plan);
+    static QString makeNativesStamp(const LaunchPlan &plan);
+
+    void log(const QString &text);
+
+    friend class PrepareTask;
+
+    LaunchPreparer &operator=(LaunchPreparer const &);
+    LaunchPreparer(LaunchPreparer const &);
+
+private slots:
+    void start();
+};
+
+#endif // LAUNCHPREPARER_H
@@ -0,0 +1,127 @@
+#include <QApplication>
+
+#include "localversions.h"
+#include "jsonparser.h"
+#include "logger.h"
+
+static const QString manifestName = "local_versions.json";
+
+QString LocalVersions::findLatest(const QString &versionsDir)
+{
+    QJsonObject versions = load(versionsDir);
+
+    QDir::Filters filters = QDir::Dirs | QDir::NoDotAndDotDot;
+    QStringList installed = QDir(versionsDir).entryList(filters);
+    QStringList known = versions.keys();
+
+    installed.sort();
+    known.sort();
+
+    // Versions may be added or removed by hand, so read the new ones
+    if (installed != known)
+    {
+        log( QApplication::translate("LocalVersions",
+                                     "Rebuilding local versions list...") );
+
+        QJsonObject actual;
+        foreach (QString version, installed)
+        {
+            if ( versions.contains(version) )
+            {
+                actual[version] = versions[version];
+            }
+            else
+            {
+                actual[version] = readReleaseTime(versionsDir, version);
+            }
+        }
+
+        versions = actual;
+        save(versionsDir, versions);
+    }
+
+    QString latest;
+
+    QString time = "1991-05-18T13:15:00+07:00";
+    QDateTime oldTime = QDateTime::fromString(time, Qt::ISODate);
+
+    foreach ( QString version, versions.keys() )
+    {
+        QString relString = versions[version].toString();
+        QDateTime relTime = QDateTime::fromString(relString, Qt::ISODate);
+
+        if ( relTime.isValid() && (relTime > oldTime) )
+        {
+            oldTime = relTime;
+            latest = version;
+        }
+    }
+
+    return latest;
+}
+
+void LocalVersions::update(const QString &versionsDir, const QString &version)
+{
+    QJsonObject versions = load(versionsDir);
+    versions[version] = readReleaseTime(versionsDir, version);
+    save(versionsDir, versions);
+}
+
+QJsonObject LocalVersions::load(const QString &versionsDir)
+{
+    QFile file(versionsDir + "/" + manifestName);
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        return QJsonObject();
+    }
+
+    QJsonDocument json = QJsonDocument::fromJson( file.readAll() );
+    file.close();
+
+    return json.object()["versions"].toObject();
+}
+
+void LocalVersions::save(const QString &versionsDir,
+                         const QJsonObject &versions)
+{
+    QJsonObject root;
+    root["versions"] = versions;
+
+    QSaveFile file(versionsDir + "/" + manifestName);
+    if ( file.open(QIODevice::WriteOnly) )
+    {
+        file.write( QJsonDocument(root).toJson(QJsonDocument::Compact) );
+        if ( file.commit() )
+        {
+            return;
+        }
+    }
+
+    QString message = QApplication::translate("LocalVersions", "Error! %1");
+    log( message.arg( file.errorString() ) );
+}
+
+QString LocalVersions::readReleaseTime(const QString &versionsDir,
+                                       const QString &version)
+{
+    JsonParser parser;
+    QString path = versionsDir + "/" + version + "/" + version + ".json";
+
+    // Directories without valid index are remembered with empty time
+    if ( parser.setJsonFromFile(path) && parser.hasReleaseTime() )
+    {
+        QDateTime relTime = parser.getReleaseTime();
+        if ( relTime.isValid() )
+        {
+            return relTime.toString(Qt::ISODate);
+        }
+    }
+
+    return "";
+}
+
+void LocalVersions::log(const QString &text)
+{
+    QString sender = QApplication::translate("LocalVersions", "LocalVersions");
+    Logger::logger()->appendLine(sender, text);
+}
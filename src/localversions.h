@@ -0,0 +1,24 @@
+#ifndef LOCALVERSIONS_H
+#define LOCALVERSIONS_H
+
+#include <QtCore>
+
+// Release times of installed versions, stored in the versions directory,
+// so the latest local version is found without parsing every version index
+class LocalVersions
+{
+public:
+    static QString findLatest(const QString &versionsDir);
+    static void update(const QString &versionsDir, const QString &version);
+
+private:
+    static QJsonObject load(const QString &versionsDir);
+    static void save(const QString &versionsDir, const QJsonObject &versions);
+
+    static QString readReleaseTime(const QString &versionsDir,
+                                   const QString &version);
+
+    static void log(const QString &text);
+};
+
+#endif // LOCALVERSIONS_H
@@ -5,6 +5,25 @@
 #include <QDate>
 #include <QTextStream>
 
+// Drains the logger queue in background
+class LogWriter : public QThread
+{
+public:
+    explicit LogWriter(Logger *owner)
+    {
+        logger = owner;
+    }
+
+protected:
+    void run()
+    {
+        logger->writeLoop();
+    }
+
+private:
+    Logger *logger;
+};
+
 Logger *Logger::myInstance = NULL;
 Logger *Logger::logger()
 {
@@ -48,6 +67,26 @@ Logger::Logger(QObject *parent) :
         qCritical() << "Can't setup logger!";
     }
 
+    // Setup queue and writer
+    cells = new Cell[Capacity];
+    for (quint32 i = 0; i < Capacity; i++)
+    {
+        cells[i].sequence.store(i);
+    }
+
+    enqueuePos.store(0);
+    dequeuePos = 0;
+
+    stopping.store(0);
+    stopped.store(0);
+    sleeping.store(0);
+
+    writer = new LogWriter(this);
+    writer->start(QThread::LowPriority);
+
+    // Write the rest of lines before application exit
+    qAddPostRoutine(Logger::shutdown);
+
     QString date = QDate::currentDate().toString("dd.MM.yy");
     QString version = Settings::instance()->launcherVersion;
 
@@ -58,18 +97,185 @@ Logger::Logger(QObject *parent) :
 
 void Logger::appendLine(const QString &sender, const QString &text)
 {
-    QString time = QTime::currentTime().toString("hh:mm:ss");
-    QString prefix = "[" + time + "] " + sender + " >> ";
+    Record record;
+    record.time = QTime::currentTime();
+    record.sender = sender;
+    record.text = text;
+
+    if ( stopped.load() )
+    {
+        QString time = record.time.toString("hh:mm:ss");
+        writeDirect("[" + time + "] " + sender + " >> " + text);
+        return;
+    }
+
+    push(record);
+}
+
+void Logger::push(const Record &record)
+{
+    quint32 pos = enqueuePos.load();
 
-    QTextStream(stdout) << prefix << text << "\n";
+    forever
+    {
+        Cell *cell = &cells[pos % Capacity];
+        quint32 sequence = cell->sequence.loadAcquire();
+        qint32 diff = qint32(sequence - pos);
+
+        if (diff == 0)
+        {
+            // Cell is free, try to reserve it
+            if ( enqueuePos.testAndSetRelaxed(pos, pos + 1) )
+            {
+                cell->record = record;
+                cell->sequence.storeRelease(pos + 1);
+
+                // Full barrier, so the writer either sees the line
+                // or is seen sleeping
+                if ( sleeping.fetchAndAddOrdered(0) )
+                {
+                    wakeWriter();
+                }
+                return;
+            }
+            pos = enqueuePos.load();
+        }
+        else if (diff < 0)
+        {
+            // Queue is full, wait for the writer
+            QThread::yieldCurrentThread();
+            pos = enqueuePos.load();
+        }
+        else
+        {
+            pos = enqueuePos.load();
+        }
+    }
+}
+
+bool Logger::pop(Record &record)
+{
+    Cell *cell = &cells[dequeuePos % Capacity];
+    quint32 sequence = cell->sequence.loadAcquire();
+
+    if (sequence != dequeuePos + 1)
+    {
+        return false;
+    }
+
+    record = cell->record;
+    cell->record = Record();
+    cell->sequence.storeRelease(dequeuePos + Capacity);
+    dequeuePos++;
+
+    return true;
+}
+
+bool Logger::hasPending()
+{
+    Cell *cell = &cells[dequeuePos % Capacity];
+    return cell->sequence.loadAcquire() == dequeuePos + 1;
+}
+
+void Logger::wakeWriter()
+{
+    QMutexLocker locker(&wakeMutex);
+    wakeCondition.wakeOne();
+}
+
+void Logger::writeLoop()
+{
+    QTextStream out(stdout);
+
+    QTextStream logStream(&logFile);
+    logStream.setCodec("UTF-8");
+
+    int lastSecond = -1;
+    QString time;
+
+    forever
+    {
+        // Lines appended before the stop request must be written
+        bool stop = stopping.load();
+
+        QStringList lines;
+        Record record;
+        while ( pop(record) )
+        {
+            int second = record.time.msecsSinceStartOfDay() / 1000;
+            if (second != lastSecond)
+            {
+                lastSecond = second;
+                time = record.time.toString("hh:mm:ss");
+            }
+
+            lines << "[" + time + "] " + record.sender + " >> " + record.text;
+        }
+
+        if ( !lines.isEmpty() )
+        {
+            QString batch = lines.join("\n");
+
+            out << batch << "\n";
+            out.flush();
+
+            if ( logFile.isOpen() )
+            {
+                logStream << batch << "\n";
+                logStream.flush();
+            }
+
+            emit lineAppended(batch);
+        }
+
+        if (stop)
+        {
+            return;
+        }
+
+        if ( !lines.isEmpty() )
+        {
+            // Let more lines come to write them in one batch
+            QThread::msleep(FlushInterval);
+            continue;
+        }
+
+        // Timed wait is a fallback in case a wakeup is missed
+        wakeMutex.lock();
+        sleeping.fetchAndStoreOrdered(1);
+
+        if ( !hasPending() && !stopping.load() )
+        {
+            wakeCondition.wait(&wakeMutex, IdleTimeout);
+        }
+
+        sleeping.fetchAndStoreOrdered(0);
+        wakeMutex.unlock();
+    }
+}
+
+void Logger::writeDirect(const QString &line)
+{
+    QTextStream(stdout) << line << "\n";
 
     if ( logFile.isOpen() )
     {
         QTextStream logStream(&logFile);
         logStream.setCodec("UTF-8");
 
-        logStream << prefix << text << "\n";
+        logStream << line << "\n";
+    }
+}
+
+void Logger::shutdown()
+{
+    if (myInstance == NULL || myInstance->stopped.load())
+    {
+        return;
     }
 
-    emit lineAppended(prefix + text);
+    myInstance->stopping.store(1);
+    myInstance->wakeWriter();
+    myInstance->writer->wait();
+    myInstance->stopped.store(1);
 }
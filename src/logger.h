@@ -11,9 +11,52 @@ private:
 
     static Logger *myInstance;
 
+    struct Record
+    {
+        QTime time;
+        QString sender;
+        QString text;
+    };
+
+    struct Cell
+    {
+        QAtomicInteger<quint32> sequence;
+        Record record;
+    };
+
+    // Bounded lock-free queue: lines are appended from any thread
+    // and written in batches by the writer thread
+    enum { Capacity = 4096, FlushInterval = 50, IdleTimeout = 1000 };
+
+    Cell *cells;
+    QAtomicInteger<quint32> enqueuePos;
+    quint32 dequeuePos;
+
+    QThread *writer;
+    QAtomicInt stopping;
+    QAtomicInt stopped;
+
+    // Idle writer waits for new lines instead of polling the queue
+    QAtomicInt sleeping;
+    QMutex wakeMutex;
+    QWaitCondition wakeCondition;
+
     QFile logFile;
     QIODevice::OpenMode mode;
 
+    void push(const Record &record);
+    bool pop(Record &record);
+    bool hasPending();
+
+    void wakeWriter();
+
+    void writeLoop();
+    void writeDirect(const QString &line);
+
+    static void shutdown();
+
+    friend class LogWriter;
+
     Logger &operator=(Logger const &);
     Logger(Logger const &);
 
@@ -2,6 +2,8 @@
 
 #include "logger.h"
 #include "settings.h"
+#include "installmanifest.h"
+#include "updatetransaction.h"
 
 #include <QApplication>
 #include <QSplashScreen>
@@ -27,6 +29,9 @@ int main(int argc, char *argv[])
 
     Settings::instance();
     Logger::logger();
+    InstallManifest::instance();
+
+    UpdateTransaction::recover();
 
 #ifdef Q_OS_WIN
     QCommandLineParser args;
@@ -142,20 +147,20 @@ int main(int argc, char *argv[])
     }
 #endif
 
+    Settings::instance()->updateLocalData();
+
+#ifdef Q_OS_WIN
     QPixmap logo(":/resources/logo.png");
     QSplashScreen *splash
         = new QSplashScreen(logo, Qt::FramelessWindowHint | Qt::SplashScreen);
     splash->setMask( logo.mask() );
     splash->show();
 
-    Settings::instance()->updateLocalData();
-
-#ifdef Q_OS_WIN
     Settings::instance()->fetchLatestVersion();
-#endif
 
     splash->close();
     delete splash;
+#endif
 
     LauncherWindow w;
     w.show();
@@ -0,0 +1,295 @@
+#include "mirrorlist.h"
+#include "settings.h"
+#include "datafetcher.h"
+#include "bandwidthlimiter.h"
+#include "logger.h"
+
+MirrorList *MirrorList::myInstance = NULL;
+MirrorList *MirrorList::instance()
+{
+    if (myInstance == NULL)
+    {
+        myInstance = new MirrorList();
+    }
+    return myInstance;
+}
+
+MirrorList::MirrorList(QObject *parent) : QObject(parent)
+{
+    fetcher = NULL;
+    probeIndex = -1;
+
+    Mirror main;
+    main.url = Settings::updateServer;
+    main.latency = -1;
+    main.failed = false;
+
+    mirrors << main;
+    current = 0;
+
+    probeTimer.setInterval(probeInterval);
+    connect(&probeTimer, &QTimer::timeout, this, &MirrorList::probe);
+}
+
+void MirrorList::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("MirrorList"), text);
+}
+
+void MirrorList::setMirrors(const QStringList &urls)
+{
+    QStringList actual;
+    actual << Settings::updateServer;
+
+    foreach (QString url, urls)
+    {
+        while ( url.endsWith('/') )
+        {
+            url.chop(1);
+        }
+
+        if ( !url.isEmpty() && !actual.contains(url) )
+        {
+            actual << url;
+        }
+    }
+
+    QStringList known;
+    foreach (const Mirror &mirror, mirrors)
+    {
+        known << mirror.url;
+    }
+
+    if (actual == known)
+    {
+        return;
+    }
+
+    QString server = getServer();
+
+    // Running probe measures the old list
+    if (probeIndex != -1)
+    {
+        fetcher->cancel();
+        probeIndex = -1;
+    }
+
+    mirrors.clear();
+    foreach (const QString &url, actual)
+    {
+        Mirror mirror;
+        mirror.url = url;
+        mirror.latency = -1;
+        mirror.failed = false;
+
+        mirrors << mirror;
+    }
+
+    log( tr("Mirrors: %1").arg( actual.join(", ") ) );
+
+    // Keep the server in use while it is still listed
+    current = qMax(0, actual.indexOf(server));
+    if (mirrors[current].url != server)
+    {
+        emit serverChanged();
+    }
+
+    if (mirrors.count() > 1)
+    {
+        QTimer::singleShot(probeDelay, this, SLOT(probe()));
+        probeTimer.start();
+    }
+    else
+    {
+        probeTimer.stop();
+    }
+}
+
+QString MirrorList::getServer() const
+{
+    return mirrors[current].url;
+}
+
+QUrl MirrorList::failover(const QUrl &url)
+{
+    if (mirrors.count() < 2)
+    {
+        return QUrl();
+    }
+
+    QString address = url.toString();
+
+    int failedIndex = -1;
+    for (int i = 0; i < mirrors.count(); i++)
+    {
+        if ( address.startsWith(mirrors[i].url + "/") )
+        {
+            failedIndex = i;
+            break;
+        }
+    }
+
+    if (failedIndex == -1)
+    {
+        return QUrl();
+    }
+
+    Mirror &failed = mirrors[failedIndex];
+    if (!failed.failed)
+    {
+        log( tr("Mirror failed: %1").arg(failed.url) );
+        failed.failed = true;
+    }
+
+    int best = findBest();
+    if (best == -1)
+    {
+        return QUrl();
+    }
+
+    if (failedIndex == current)
+    {
+        select(best);
+    }
+
+    QString path = address.mid( failed.url.length() );
+    return QUrl(mirrors[best].url + path);
+}
+
+QUrl MirrorList::getMainServerUrl(const QUrl &url) const
+{
+    QString address = url.toString();
+
+    // Main server is always the first one
+    for (int i = 1; i < mirrors.count(); i++)
+    {
+        QString prefix = mirrors[i].url;
+        if ( address.startsWith(prefix + "/") )
+        {
+            return QUrl( mirrors[0].url + address.mid( prefix.length() ) );
+        }
+    }
+
+    return QUrl();
+}
+
+int MirrorList::findBest() const
+{
+    // Mirrors without measurements go after measured ones,
+    // in the order they are listed
+    int best = -1;
+
+    for (int i = 0; i < mirrors.count(); i++)
+    {
+        const Mirror &mirror = mirrors[i];
+        if (mirror.failed)
+        {
+            continue;
+        }
+
+        if (best == -1)
+        {
+            best = i;
+            continue;
+        }
+
+        qint64 bestLatency = mirrors[best].latency;
+        if ( mirror.latency != -1
+             && (bestLatency == -1 || mirror.latency < bestLatency) )
+        {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+void MirrorList::select(int index)
+{
+    if (index == current)
+    {
+        return;
+    }
+
+    current = index;
+    log( tr("Using mirror: %1").arg(mirrors[current].url) );
+
+    emit serverChanged();
+}
+
+void MirrorList::probe()
+{
+    if (probeIndex != -1 || mirrors.count() < 2)
+    {
+        return;
+    }
+
+    // Measurements would be spoiled by the limit
+    if ( BandwidthLimiter::instance()->isLimited() )
+    {
+        return;
+    }
+
+    if (fetcher == NULL)
+    {
+        fetcher = new DataFetcher(this);
+        fetcher->setFailoverEnabled(false);
+
+        connect(fetcher, &DataFetcher::finished,
+                this, &MirrorList::onProbeFinished);
+    }
+
+    log( tr("Probing mirrors...") );
+
+    probeIndex = 0;
+    probeNext();
+}
+
+void MirrorList::probeNext()
+{
+    // Index file is small, so the time is mostly latency
+    QString url = mirrors[probeIndex].url + "/prefixes.json";
+
+    probeClock.start();
+    fetcher->makeGet( QUrl(url) );
+}
+
+void MirrorList::onProbeFinished(bool result)
+{
+    qint64 elapsed = probeClock.elapsed();
+    Mirror &mirror = mirrors[probeIndex];
+
+    if (result)
+    {
+        qint64 size = fetcher->getData().size();
+        qint64 speed = size * 1000 / qMax(elapsed, qint64(1)) / 1024;
+
+        mirror.latency = elapsed;
+        mirror.failed = false;
+
+        log( tr("Mirror %1: %2 ms, %3 KB/s")
+             .arg(mirror.url).arg(elapsed).arg(speed) );
+    }
+    else
+    {
+        mirror.latency = -1;
+        mirror.failed = true;
+
+        log( tr("Mirror %1 is not available.").arg(mirror.url) );
+    }
+
+    probeIndex++;
+    if ( probeIndex < mirrors.count() )
+    {
+        probeNext();
+        return;
+    }
+
+    probeIndex = -1;
+
+    int best = findBest();
+    if (best != -1)
+    {
+        select(best);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef MIRRORLIST_H
+#define MIRRORLIST_H
+
+#include <QtCore>
+
+class DataFetcher;
+
+// Update server mirrors. All of them are probed from time to time and
+// the fastest one is used, failed requests are repeated on the others
+class MirrorList : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MirrorList *instance();
+
+    // Main update server is always in the list
+    void setMirrors(const QStringList &urls);
+
+    QString getServer() const;
+
+    // Marks mirror of the url as failed and returns the same url
+    // on the next best mirror, or invalid url if there is none
+    QUrl failover(const QUrl &url);
+
+    // Same url on the main update server, invalid if the url is not
+    // on another mirror. Mirrors may lag behind the main server
+    QUrl getMainServerUrl(const QUrl &url) const;
+
+public slots:
+    void probe();
+
+signals:
+    void serverChanged();
+
+private:
+    explicit MirrorList(QObject *parent = 0);
+
+    static MirrorList *myInstance;
+
+    static const int probeDelay = 5000;
+    static const int probeInterval = 10 * 60 * 1000;
+
+    struct Mirror
+    {
+        QString url;
+
+        // Time to fetch the probe file, -1 if unknown
+        qint64 latency;
+        bool failed;
+    };
+
+    QList<Mirror> mirrors;
+    int current;
+
+    QTimer probeTimer;
+
+    DataFetcher *fetcher;
+    QElapsedTimer probeClock;
+    int probeIndex;
+
+    int findBest() const;
+    void select(int index);
+
+    void probeNext();
+    void log(const QString &text);
+
+    MirrorList &operator=(MirrorList const &);
+    MirrorList(MirrorList const &);
+
+private slots:
+    void onProbeFinished(bool result);
+};
+
+#endif // MIRRORLIST_H
@@ -0,0 +1,472 @@
+#include "segmenteddownload.h"
+#include "settings.h"
+#include "bandwidthlimiter.h"
+#include "mirrorlist.h"
+#include "logger.h"
+
+SegmentedDownload::SegmentedDownload(QObject *parent) : QObject(parent)
+{
+    nam = Settings::instance()->getNetworkAccessManager();
+
+    size = 0;
+    written = 0;
+    readTurn = 0;
+    downloadId = 0;
+
+    waiting = false;
+    rangeUnsupported = false;
+
+    throttleTimer.setSingleShot(true);
+    throttleTimer.setInterval(throttleInterval);
+
+    connect(&throttleTimer, &QTimer::timeout,
+            this, &SegmentedDownload::readAllSegments);
+
+    watchdog.setInterval(watchdogInterval);
+
+    connect(&watchdog, &QTimer::timeout,
+            this, &SegmentedDownload::checkActivity);
+}
+
+SegmentedDownload::~SegmentedDownload()
+{
+    cancel();
+}
+
+void SegmentedDownload::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("SegmentedDownload"), text);
+}
+
+bool SegmentedDownload::isWaiting() const
+{
+    return waiting;
+}
+
+bool SegmentedDownload::isRangeUnsupported() const
+{
+    return rangeUnsupported;
+}
+
+const QString &SegmentedDownload::errorString() const
+{
+    return error;
+}
+
+void SegmentedDownload::start(const QUrl &url, const QString &fileName,
+                              qint64 size)
+{
+    cancel();
+
+    this->url = url;
+    this->size = size;
+
+    written = 0;
+    readTurn = 0;
+    rangeUnsupported = false;
+    error.clear();
+
+    QDir fdir = QFileInfo(fileName).absoluteDir();
+    fdir.mkpath( fdir.absolutePath() );
+
+    // File may be hard-linked from a local store, so never write
+    // through it, replace it instead
+    QFile::remove(fileName);
+
+    // Whole file is allocated at once, segments are written into it
+    file.setFileName(fileName);
+    if ( !file.open(QIODevice::WriteOnly) || !file.resize(size) )
+    {
+        error = file.errorString();
+        log( tr("Error! %1").arg(error) );
+
+        file.close();
+        emit finished(false);
+        return;
+    }
+
+    int count = int(size / minSegmentSize);
+    if (count > maxSegments)
+    {
+        count = maxSegments;
+    }
+    else if (count < 1)
+    {
+        count = 1;
+    }
+
+    qint64 length = size / count;
+
+    segments.clear();
+    for (int i = 0; i < count; i++)
+    {
+        Segment segment;
+        segment.begin = length * i;
+        segment.end = (i == count - 1) ? size - 1 : length * (i + 1) - 1;
+        segment.offset = segment.begin;
+        segment.retries = 0;
+        segment.reply = NULL;
+
+        segments << segment;
+    }
+
+    log( tr("Download %1 in %2 segments")
+         .arg( url.toString() ).arg(count) );
+
+    waiting = true;
+
+    for (int i = 0; i < segments.count(); i++)
+    {
+        startSegment(i);
+    }
+
+    watchdog.start();
+}
+
+void SegmentedDownload::startSegment(int index)
+{
+    Segment &segment = segments[index];
+
+    QString range = QString("bytes=%1-%2")
+            .arg(segment.offset).arg(segment.end);
+
+    QNetworkRequest request(url);
+    request.setRawHeader( "Range", range.toLatin1() );
+
+    segment.reply = nam->get(request);
+    segment.reply->setReadBufferSize(readBufferSize);
+    segment.activity.start();
+
+    connect(segment.reply, &QNetworkReply::readyRead,
+            this, &SegmentedDownload::onReadyRead);
+
+    connect(segment.reply, &QNetworkReply::finished,
+            this, &SegmentedDownload::onSegmentFinished);
+}
+
+void SegmentedDownload::stopSegment(int index)
+{
+    QNetworkReply *reply = segments[index].reply;
+    if (reply == NULL)
+    {
+        return;
+    }
+
+    segments[index].reply = NULL;
+
+    disconnect(reply, 0, this, 0);
+    if ( reply->isRunning() )
+    {
+        reply->abort();
+    }
+
+    reply->deleteLater();
+}
+
+void SegmentedDownload::stopAll()
+{
+    waiting = false;
+    downloadId++;
+
+    throttleTimer.stop();
+    watchdog.stop();
+
+    for (int i = 0; i < segments.count(); i++)
+    {
+        stopSegment(i);
+    }
+}
+
+int SegmentedDownload::findSegment(QObject *reply) const
+{
+    for (int i = 0; i < segments.count(); i++)
+    {
+        if (segments[i].reply == reply)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool SegmentedDownload::readSegment(int index, bool final)
+{
+    Segment &segment = segments[index];
+    QNetworkReply *reply = segment.reply;
+
+    QNetworkRequest::Attribute code = QNetworkRequest::HttpStatusCodeAttribute;
+    int status = reply->attribute(code).toInt();
+
+    // Whole file would be written over the segment
+    if (status == 200)
+    {
+        rangeUnsupported = true;
+        fail( tr("Server does not support ranges.") );
+        return false;
+    }
+
+    // Error page, the reply fails on finish
+    if (status != 206)
+    {
+        reply->readAll();
+        return true;
+    }
+
+    qint64 available = reply->bytesAvailable();
+    qint64 allowed = available;
+
+    if (final)
+    {
+        // Tail of the reply can't be delayed anymore
+        BandwidthLimiter::instance()->charge(available);
+    }
+    else
+    {
+        allowed = BandwidthLimiter::instance()->take(available);
+    }
+
+    if (allowed <= 0)
+    {
+        return true;
+    }
+
+    QByteArray chunk = reply->read(allowed);
+    if (chunk.size() > segment.end + 1 - segment.offset)
+    {
+        fail( tr("Server sent more than requested.") );
+        return false;
+    }
+
+    // Single thread writes all segments, so seek and write
+    // together make a positioned write
+    if ( !file.seek(segment.offset)
+         || file.write(chunk) != chunk.size() )
+    {
+        fail( file.errorString() );
+        return false;
+    }
+
+    segment.offset += chunk.size();
+    segment.activity.restart();
+
+    written += chunk.size();
+    emit progress(written, size);
+
+    return true;
+}
+
+void SegmentedDownload::onReadyRead()
+{
+    int index = findSegment( sender() );
+    if (index == -1 || !waiting)
+    {
+        return;
+    }
+
+    if ( !readSegment(index, false) )
+    {
+        return;
+    }
+
+    // Full buffer stops the connection until the rest is read
+    if ( segments[index].reply->bytesAvailable() > 0 )
+    {
+        throttleTimer.start();
+    }
+}
+
+void SegmentedDownload::readAllSegments()
+{
+    bool pending = false;
+    int count = segments.count();
+
+    for (int n = 0; n < count; n++)
+    {
+        int index = (readTurn + n) % count;
+        if (segments[index].reply == NULL)
+        {
+            continue;
+        }
+
+        if ( !readSegment(index, false) )
+        {
+            return;
+        }
+
+        if ( segments[index].reply->bytesAvailable() > 0 )
+        {
+            pending = true;
+        }
+    }
+
+    readTurn = (readTurn + 1) % count;
+
+    if (pending)
+    {
+        throttleTimer.start();
+    }
+}
+
+void SegmentedDownload::onSegmentFinished()
+{
+    int index = findSegment( sender() );
+    if (index == -1 || !waiting)
+    {
+        return;
+    }
+
+    Segment &segment = segments[index];
+    QNetworkReply::NetworkError code = segment.reply->error();
+
+    if (code != QNetworkReply::NoError)
+    {
+        QString reason = segment.reply->errorString();
+
+        QUrl replyUrl = segment.reply->request().url();
+        QUrl mainUrl = MirrorList::instance()->getMainServerUrl(replyUrl);
+
+        // New files may have not reached the mirror yet
+        if (code == QNetworkReply::ContentNotFoundError && mainUrl.isValid())
+        {
+            if (url != mainUrl)
+            {
+                log( tr("File is missing on the mirror, using %1")
+                     .arg( mainUrl.toString() ) );
+                url = mainUrl;
+            }
+
+            retrySegment(index, reason);
+        }
+        // Other content errors won't go away on retry
+        else if ( code >= QNetworkReply::ContentAccessDenied
+                  && code < QNetworkReply::InternalServerError )
+        {
+            fail(reason);
+        }
+        else
+        {
+            retrySegment(index, reason);
+        }
+
+        return;
+    }
+
+    if ( !readSegment(index, true) )
+    {
+        return;
+    }
+
+    stopSegment(index);
+
+    if (segment.offset <= segment.end)
+    {
+        retrySegment( index, tr("Connection closed early.") );
+        return;
+    }
+
+    for (int i = 0; i < segments.count(); i++)
+    {
+        if (segments[i].offset <= segments[i].end)
+        {
+            return;
+        }
+    }
+
+    finish();
+}
+
+void SegmentedDownload::retrySegment(int index, const QString &reason)
+{
+    stopSegment(index);
+
+    Segment &segment = segments[index];
+    segment.retries++;
+
+    if (segment.retries > maxRetries)
+    {
+        fail( tr("Segment %1 failed: %2").arg(index).arg(reason) );
+        return;
+    }
+
+    log( tr("Segment %1 failed: %2, retry from byte %3")
+         .arg(index).arg(reason).arg(segment.offset) );
+
+    int id = downloadId;
+    QTimer::singleShot(retryDelay, this, [=]()
+    {
+        if (id == downloadId && waiting)
+        {
+            startSegment(index);
+        }
+    });
+}
+
+void SegmentedDownload::checkActivity()
+{
+    for (int i = 0; i < segments.count() && waiting; i++)
+    {
+        Segment &segment = segments[i];
+        if (segment.reply == NULL)
+        {
+            continue;
+        }
+
+        // Unread data means the segment waits for bandwidth, not stalls
+        if ( segment.reply->bytesAvailable() > 0 )
+        {
+            segment.activity.restart();
+            continue;
+        }
+
+        if (segment.activity.elapsed() > stallTimeout)
+        {
+            retrySegment( i, tr("Connection timed out!") );
+        }
+    }
+}
+
+void SegmentedDownload::fail(const QString &reason)
+{
+    error = reason;
+    log( tr("Error! %1").arg(error) );
+
+    stopAll();
+
+    file.close();
+    file.remove();
+
+    emit finished(false);
+}
+
+void SegmentedDownload::finish()
+{
+    stopAll();
+    file.close();
+
+    if (written != size)
+    {
+        error = tr("Size mismatch: %1 of %2 bytes.").arg(written).arg(size);
+        log( tr("Error! %1").arg(error) );
+
+        file.remove();
+
+        emit finished(false);
+        return;
+    }
+
+    emit finished(true);
+}
+
+void SegmentedDownload::cancel()
+{
+    if (!waiting)
+    {
+        return;
+    }
+
+    stopAll();
+
+    file.close();
+    file.remove();
+}
@@ -0,0 +1,108 @@
+#ifndef SEGMENTEDDOWNLOAD_H
+#define SEGMENTEDDOWNLOAD_H
+
+#include <QtCore>
+#include <QtNetwork>
+
+// Large file fetched by byte ranges over several connections at once.
+// Each range is written straight to its place in the file, failed ranges
+// are resumed from the last written byte
+class SegmentedDownload : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentedDownload(QObject *parent = 0);
+    ~SegmentedDownload();
+
+    static const qint64 threshold = 8 * 1024 * 1024;
+
+    void start(const QUrl &url, const QString &fileName, qint64 size);
+
+    bool isWaiting() const;
+
+    // Server answered without ranges, the file has to be fetched whole
+    bool isRangeUnsupported() const;
+
+    const QString &errorString() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(qint64 bytesReceived, qint64 bytesTotal);
+    void finished(bool result);
+
+private:
+    static const int maxSegments = 4;
+    static const qint64 minSegmentSize = 2 * 1024 * 1024;
+
+    static const int maxRetries = 3;
+    static const int retryDelay = 1000;
+
+    static const int readBufferSize = 256 * 1024;
+    static const int throttleInterval = 50;
+
+    static const int watchdogInterval = 1000;
+    static const int stallTimeout = 15000;
+
+    struct Segment
+    {
+        // Last byte is included, as in the Range header
+        qint64 begin;
+        qint64 end;
+
+        // Next byte to write
+        qint64 offset;
+
+        int retries;
+        QNetworkReply *reply;
+        QElapsedTimer activity;
+    };
+
+    QNetworkAccessManager *nam;
+
+    QUrl url;
+    QFile file;
+    qint64 size;
+
+    QList<Segment> segments;
+    qint64 written;
+
+    // Limited bandwidth is shared between segments in turn
+    int readTurn;
+
+    // Delayed retries of a stopped download are ignored
+    int downloadId;
+
+    bool waiting;
+    bool rangeUnsupported;
+    QString error;
+
+    QTimer throttleTimer;
+    QTimer watchdog;
+
+    void startSegment(int index);
+    void stopSegment(int index);
+    void stopAll();
+
+    int findSegment(QObject *reply) const;
+    bool readSegment(int index, bool final);
+
+    void retrySegment(int index, const QString &reason);
+    void fail(const QString &reason);
+    void finish();
+
+    void log(const QString &text);
+
+    SegmentedDownload &operator=(SegmentedDownload const &);
+    SegmentedDownload(SegmentedDownload const &);
+
+private slots:
+    void onReadyRead();
+    void onSegmentFinished();
+    void readAllSegments();
+    void checkActivity();
+};
+
+#endif // SEGMENTEDDOWNLOAD_H
@@ -9,6 +9,8 @@
 #include "jsonparser.h"
 
 #include "util.h"
+#include "gamelog.h"
+#include "mirrorlist.h"
 
 typedef QStandardPaths Path;
 
@@ -43,6 +45,7 @@ Settings::Settings() : QObject()
     latestVersion = launcherVersion;
 
     nam = new QNetworkAccessManager(this);
+    localDataFetcher = NULL;
 
     Path::StandardLocation dataLocation = Path::GenericDataLocation;
     Path::StandardLocation configLocation = Path::GenericConfigLocation;
@@ -55,6 +58,20 @@ Settings::Settings() : QObject()
     QDir(configPath).mkpath(configPath);
 
     settings = new QSettings(configPath + "/config.ini", QSettings::IniFormat);
+
+    activeClientID = -1;
+    updateClientSnapshot();
+
+    // Platform info is taken from cache and refreshed after startup
+#ifdef Q_OS_LINUX
+    osVersion = settings->value("platform/os_version").toString();
+    if ( osVersion.isEmpty() )
+    {
+        osVersion = "unknown";
+    }
+
+    QTimer::singleShot(0, this, &Settings::refreshOsVersion);
+#endif
 }
 
 void Settings::log(const QString &text)
@@ -62,27 +79,58 @@ void Settings::log(const QString &text)
     Logger::logger()->appendLine(tr("Settings"), text);
 }
 
+// Clients from cached index are available at once,
+// fresh data is fetched in background
 void Settings::updateLocalData()
 {
-    QUrl keystoreUrl(updateServer + "/store.ks");
+    loadClients();
+
+    QString server = MirrorList::instance()->getServer();
+
+    QUrl keystoreUrl(server + "/store.ks");
     QString keystorePath = configPath + "/keystore.ks";
 
-    QUrl clientsUrl(updateServer + "/prefixes.json");
+    QUrl clientsUrl(server + "/prefixes.json");
     QString clientsPath = dataPath + "/prefixes.json";
 
+    if (localDataFetcher == NULL)
+    {
+        localDataFetcher = new FileFetcher(this);
+        localDataFetcher->setHiddenLenght(0);
+
+        connect(localDataFetcher, &FileFetcher::filesFetchResult,
+                this, &Settings::localDataFetched);
+    }
+
     log( tr("Updating local data...") );
 
-    FileFetcher fetcher;
-    fetcher.setHiddenLenght(0);
-    fetcher.add(keystoreUrl, keystorePath);
-    fetcher.add(clientsUrl, clientsPath);
+    localDataFetcher->reset();
+    localDataFetcher->add(keystoreUrl, keystorePath);
+    localDataFetcher->add(clientsUrl, clientsPath);
+    localDataFetcher->fetchFiles();
+}
 
-    QEventLoop loop;
-    QObject::connect(&fetcher, &FileFetcher::filesFetchFinished,
-                     &loop, &QEventLoop::quit);
+void Settings::localDataFetched(bool result)
+{
+    if (result)
+    {
+        log( tr("Local data updated.") );
+    }
+    else
+    {
+        log( tr("Error! Local data is not updated, using cached data.") );
+    }
 
-    fetcher.fetchFiles();
-    loop.exec();
+    loadClients();
+    emit localDataUpdated(result);
+}
+
+void Settings::loadClients()
+{
+    QString clientsPath = dataPath + "/prefixes.json";
+
+    // Local mirrors are listed in config, for example for testing
+    QStringList mirrors = settings->value("launcher/mirrors").toStringList();
 
     JsonParser parser;
     if ( parser.setJsonFromFile(clientsPath) )
@@ -95,11 +143,61 @@ void Settings::updateLocalData()
         {
             log( tr("Error: no prefixes in prefixes.json") );
         }
+
+        if ( parser.hasMirrorList() )
+        {
+            mirrors << parser.getMirrorList();
+        }
     }
     else
     {
         log( tr("Error! %1").arg( parser.getParserError() ) );
     }
+
+    MirrorList::instance()->setMirrors(mirrors);
+
+    updateClientSnapshot();
+}
+
+void Settings::updateClientSnapshot()
+{
+    QString oldClient = activeClient;
+
+    clientNames = clients.keys();
+    clientCaptions = clients.values();
+
+    QString strid = settings->value("launcher/client", "default").toString();
+    activeClientID = clientNames.indexOf(strid);
+    activeClient = getClientName(activeClientID);
+
+    clientDir = dataPath + "/client_" + activeClient;
+
+    clientValues.clear();
+
+    if (activeClient != oldClient)
+    {
+        emit activeClientChanged();
+    }
+}
+
+QVariant Settings::loadClientValue(const QString &key,
+                                   const QVariant &def) const
+{
+    if ( !clientValues.contains(key) )
+    {
+        QString entry = "client-" + activeClient + "/" + key;
+        clientValues.insert( key, settings->value(entry, def) );
+    }
+
+    return clientValues.value(key);
+}
+
+void Settings::saveClientValue(const QString &key, const QVariant &value) const
+{
+    QString entry = "client-" + activeClient + "/" + key;
+
+    settings->setValue(entry, value);
+    clientValues.insert(key, value);
 }
 
 void Settings::fetchLatestVersion()
@@ -141,8 +239,7 @@ QString Settings::getlatestVersion() const
 
 QString Settings::getVersionsUrl() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    return updateServer + "/" + client + "/versions/versions.json";
+    return getClientUrl() + "versions/versions.json";
 }
 
 QString Settings::getVanillaVersionsUrl() const
@@ -153,33 +250,38 @@ QString Settings::getVanillaVersionsUrl() const
 
 QString Settings::getVersionUrl(const QString &version)
 {
-    QString client = getClientName( loadActiveClientID() );
-    return updateServer + "/" + client + "/" + version + "/";
+    return getClientUrl() + version + "/";
+}
+
+// Update URLs lead to the mirror in use
+QString Settings::getClientUrl() const
+{
+    return MirrorList::instance()->getServer() + "/" + activeClient + "/";
 }
 
 QString Settings::getLibsUrl() const
 {
-    return updateServer + "/libraries/";
+    return MirrorList::instance()->getServer() + "/libraries/";
 }
 
 QString Settings::getAssetsUrl() const
 {
-    return updateServer + "/assets/";
+    return MirrorList::instance()->getServer() + "/assets/";
 }
 
 QStringList Settings::getClientCaptions() const
 {
-    return clients.values();
+    return clientCaptions;
 }
 
 QStringList Settings::getClientNames() const
 {
-    return clients.keys();
+    return clientNames;
 }
 
 int Settings::getClientID(const QString &strid) const
 {
-    return clients.keys().indexOf(strid);
+    return clientNames.indexOf(strid);
 }
 
 QString Settings::getClientCaption(int index) const
@@ -196,24 +298,25 @@ QString Settings::getClientCaption(int index) const
 
 QString Settings::getClientName(int index) const
 {
-    if (index < 0 || clients.size() <= index)
+    if (index < 0 || clientNames.size() <= index)
     {
         return "unknown";
     }
 
-    return clients.keys()[index];
+    return clientNames[index];
 }
 
 int Settings::loadActiveClientID() const
 {
-    QString strid = settings->value("launcher/client", "default").toString();
-    return getClientID(strid);
+    return activeClientID;
 }
 
-void Settings::saveActiveClientID(int id) const
+void Settings::saveActiveClientID(int id)
 {
     QString client = getClientName(id);
     settings->setValue("launcher/client", client);
+
+    updateClientSnapshot();
 }
 
 QString Settings::loadLogin() const
@@ -265,65 +368,44 @@ QString Settings::makeMinecraftUuid() const
 // Minecraft window geometry
 QRect Settings::loadClientWindowGeometry() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_custom";
-
-    QVariant rect = settings->value( entry, QRect(-1, -1, 854, 480) );
+    QVariant rect = loadClientValue( "window_geometry_custom",
+                                     QRect(-1, -1, 854, 480) );
     return qvariant_cast<QRect>(rect);
 }
 
 void Settings::saveClientWindowGeometry(const QRect &g) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_custom";
-
-    settings->setValue(entry, g);
+    saveClientValue("window_geometry_custom", g);
 }
 
 bool Settings::loadClientWindowSizeState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_set";
-    return settings->value(entry, false).toBool();
+    return loadClientValue("window_geometry_set", false).toBool();
 }
 
 void Settings::saveClientWindowSizeState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_set";
-    settings->setValue(entry, state);
+    saveClientValue("window_geometry_set", state);
 }
 
 bool Settings::loadClientUseLauncherSizeState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_from_launcher";
-
-    return settings->value(entry, false).toBool();
+    return loadClientValue("window_geometry_from_launcher", false).toBool();
 }
 
 void Settings::saveClientUseLauncherSizeState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_from_launcher";
-
-    return settings->setValue(entry, state);
+    saveClientValue("window_geometry_from_launcher", state);
 }
 
 bool Settings::loadClientFullscreenState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_fullscreen";
-
-    return settings->value(entry, false).toBool();
+    return loadClientValue("window_geometry_fullscreen", false).toBool();
 }
 
 void Settings::saveClientFullscreenState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/window_geometry_fullscreen";
-
-    settings->setValue(entry, state);
+    saveClientValue("window_geometry_fullscreen", state);
 }
 
 // Launcher window geometry
@@ -370,149 +452,235 @@ void Settings::saveHideWindowModeState(bool hideState) const
     settings->setValue("launcher/hide_on_run", hideState);
 }
 
+bool Settings::loadThrottleState() const
+{
+    return settings->value("launcher/throttle_downloads", true).toBool();
+}
+
+void Settings::saveThrottleState(bool state) const
+{
+    settings->setValue("launcher/throttle_downloads", state);
+}
+
+int Settings::loadThrottleRate() const
+{
+    return settings->value("launcher/throttle_rate", 256).toInt();
+}
+
+bool Settings::loadFeedbackMultipartState() const
+{
+    return settings->value("launcher/feedback_multipart", false).toBool();
+}
+
 // Client settings
 QString Settings::loadClientVersion() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/version";
-
-    return settings->value(entry, "latest").toString();
+    return loadClientValue("version", "latest").toString();
 }
 
 void Settings::saveClientVersion(const QString &version) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/version";
-
-    settings->setValue(entry, version);
+    saveClientValue("version", version);
 }
 
 bool Settings::loadClientJavaState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/custom_java_enabled";
-
-    return settings->value(entry, false).toBool();
+    return loadClientValue("custom_java_enabled", false).toBool();
 }
 
 void Settings::saveClientJavaState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/custom_java_enabled";
-
-    settings->setValue(entry, state);
+    saveClientValue("custom_java_enabled", state);
 }
 
 QString Settings::loadClientJava() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/custom_java";
-
-    return settings->value(entry, "").toString();
+    return loadClientValue("custom_java", "").toString();
 }
 
 void Settings::saveClientJava(const QString &java) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/custom_java";
-
-    settings->setValue(entry, java);
+    saveClientValue("custom_java", java);
 }
 
 bool Settings::loadClientJavaArgsState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/cutsom_args_enabled";
-
-    return settings->value(entry, false).toBool();
+    return loadClientValue("cutsom_args_enabled", false).toBool();
 }
 
 void Settings::saveClientJavaArgsState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/cutsom_args_enabled";
-
-    settings->setValue(entry, state);
+    saveClientValue("cutsom_args_enabled", state);
 }
 
 QString Settings::loadClientJavaArgs() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/cutsom_args";
-
-    return settings->value(entry, "").toString();
+    return loadClientValue("cutsom_args", "").toString();
 }
 
 void Settings::saveClientJavaArgs(const QString &args) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/cutsom_args";
-
-    settings->setValue(entry, args);
+    saveClientValue("cutsom_args", args);
 }
 
 bool Settings::loadClientJavaKeystoreState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/java_keystore_enabled";
-
-    return settings->value(entry, false).toBool();
+    return loadClientValue("java_keystore_enabled", false).toBool();
 }
 
 void Settings::saveClientJavaKeystoreState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/java_keystore_enabled";
-
-    settings->setValue(entry, state);
+    saveClientValue("java_keystore_enabled", state);
 }
 
 QString Settings::loadClientJavaKeystorePath() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/java_keystore_path";
-
-    return settings->value(entry, "").toString();
+    return loadClientValue("java_keystore_path", "").toString();
 }
 
 void Settings::saveClientJavaKeystorePath(const QString &path) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/java_keystore_path";
-
-    settings->setValue(entry, path);
+    saveClientValue("java_keystore_path", path);
 }
 
 QString Settings::loadClientJavaKeystorePass() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/java_keystore_password";
-
-    return settings->value(entry, "").toString();
+    return loadClientValue("java_keystore_password", "").toString();
 }
 
 void Settings::saveClientJavaKeystorePass(const QString &pass) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/java_keystore_password";
-
-    settings->setValue(entry, pass);
+    saveClientValue("java_keystore_password", pass);
 }
 
 bool Settings::loadClientCheckAssetsState() const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/check_assets";
-
-    return settings->value(entry, true).toBool();
+    return loadClientValue("check_assets", true).toBool();
 }
 
 void Settings::saveClientCheckAssetsState(bool state) const
 {
-    QString client = getClientName( loadActiveClientID() );
-    QString entry = "client-" + client + "/check_assets";
+    saveClientValue("check_assets", state);
+}
+
+int Settings::loadClientClasspathMode() const
+{
+    return loadClientValue("classpath_mode", 0).toInt();
+}
+
+void Settings::saveClientClasspathMode(int mode) const
+{
+    saveClientValue("classpath_mode", mode);
+}
+
+bool Settings::loadClientCdsState() const
+{
+    return loadClientValue("class_data_sharing", false).toBool();
+}
+
+void Settings::saveClientCdsState(bool state) const
+{
+    saveClientValue("class_data_sharing", state);
+}
+
+int Settings::loadClientGameLogLevel() const
+{
+    return loadClientValue("game_log_level", GameLog::LevelInfo).toInt();
+}
+
+void Settings::saveClientGameLogLevel(int level) const
+{
+    saveClientValue("game_log_level", level);
+}
+
+bool Settings::loadClientGcLogState() const
+{
+    return loadClientValue("gc_log", false).toBool();
+}
+
+void Settings::saveClientGcLogState(bool state) const
+{
+    saveClientValue("gc_log", state);
+}
+
+bool Settings::loadClientJvmTuningState() const
+{
+    return loadClientValue("jvm_tuning", true).toBool();
+}
+
+void Settings::saveClientJvmTuningState(bool state) const
+{
+    saveClientValue("jvm_tuning", state);
+}
 
-    settings->setValue(entry, state);
+int Settings::loadClientHeapSize() const
+{
+    return loadClientValue("jvm_heap_size", 0).toInt();
+}
+
+void Settings::saveClientHeapSize(int size) const
+{
+    saveClientValue("jvm_heap_size", size);
+}
+
+int Settings::loadClientCollector() const
+{
+    return loadClientValue("jvm_collector", 0).toInt();
+}
+
+void Settings::saveClientCollector(int collector) const
+{
+    saveClientValue("jvm_collector", collector);
+}
+
+bool Settings::loadClientSchedulingState() const
+{
+    return loadClientValue("process_scheduling", false).toBool();
+}
+
+void Settings::saveClientSchedulingState(bool state) const
+{
+    saveClientValue("process_scheduling", state);
+}
+
+QString Settings::loadClientCpuAffinity() const
+{
+    return loadClientValue("process_affinity", "").toString();
+}
+
+void Settings::saveClientCpuAffinity(const QString &cpus) const
+{
+    saveClientValue("process_affinity", cpus);
+}
+
+int Settings::loadClientNiceLevel() const
+{
+    return loadClientValue("process_nice", 0).toInt();
+}
+
+void Settings::saveClientNiceLevel(int level) const
+{
+    saveClientValue("process_nice", level);
+}
+
+int Settings::loadClientIoClass() const
+{
+    return loadClientValue("process_io_class", 0).toInt();
+}
+
+void Settings::saveClientIoClass(int ioClass) const
+{
+    saveClientValue("process_io_class", ioClass);
+}
+
+int Settings::loadClientMemoryLimit() const
+{
+    return loadClientValue("process_memory_limit", 0).toInt();
+}
+
+void Settings::saveClientMemoryLimit(int limit) const
+{
+    saveClientValue("process_memory_limit", limit);
 }
 
 // Local store settings
@@ -544,6 +712,18 @@ void Settings::saveStoreDirPath(const QString &path) const
     settings->setValue(entry, path);
 }
 
+int Settings::loadStoreCopyMode() const
+{
+    QString entry = "localstore/copy_mode";
+    return settings->value(entry, 0).toInt();
+}
+
+void Settings::saveStoreCopyMode(int mode) const
+{
+    QString entry = "localstore/copy_mode";
+    settings->setValue(entry, mode);
+}
+
 // News
 bool Settings::loadNewsState() const
 {
@@ -563,12 +743,12 @@ QString Settings::getBaseDir() const
 
 QString Settings::getClientDir() const
 {
-    return dataPath + "/client_" + getClientName( loadActiveClientID() );
+    return clientDir;
 }
 
 QString Settings::getClientPrefix(const QString &version) const
 {
-    return getClientDir() + "/prefixes/" + version;
+    return clientDir + "/prefixes/" + version;
 }
 
 QString Settings::getAssetsDir() const
@@ -583,12 +763,12 @@ QString Settings::getLibsDir() const
 
 QString Settings::getVersionsDir() const
 {
-    return getClientDir() + "/versions";
+    return clientDir + "/versions";
 }
 
 QString Settings::getNativesDir() const
 {
-    return getClientDir() + "/natives";
+    return clientDir + "/natives";
 }
 
 QString Settings::getConfigDir() const
@@ -665,24 +845,80 @@ QString Settings::getOsVersion() const
 #endif
 
 #ifdef Q_OS_LINUX
-    QProcess lsbRelease;
-    lsbRelease.start("lsb_release", QStringList() << "-d");
+    return osVersion;
+#endif
+}
 
-    if ( !lsbRelease.waitForStarted() )
+void Settings::refreshOsVersion()
+{
+    QString version = readOsRelease();
+    if ( !version.isEmpty() )
     {
-        return "NO_LSB_DISTRO";
+        storeOsVersion(version);
+        return;
     }
-    if ( !lsbRelease.waitForFinished() )
+
+    // Fall back to lsb_release without waiting for it
+    QProcess *lsbRelease = new QProcess(this);
+
+    connect(lsbRelease, &QProcess::stateChanged, this,
+            [this, lsbRelease](QProcess::ProcessState state)
+    {
+        if (state != QProcess::NotRunning)
+        {
+            return;
+        }
+
+        // Get value from output: "Description:\t<value>\n"
+        QString releaseInfo = QString( lsbRelease->readLine() );
+        releaseInfo = releaseInfo.split('\t').last().split('\n').first();
+
+        if ( releaseInfo.isEmpty() )
+        {
+            releaseInfo = "NO_LSB_DISTRO";
+        }
+
+        storeOsVersion(releaseInfo);
+        lsbRelease->deleteLater();
+    });
+
+    lsbRelease->start("lsb_release", QStringList() << "-d");
+}
+
+QString Settings::readOsRelease()
+{
+    QStringList paths;
+    paths << "/etc/os-release" << "/usr/lib/os-release";
+
+    foreach (QString path, paths)
     {
-        return "ERROR";
+        QFile file(path);
+        if ( !file.open(QIODevice::ReadOnly | QIODevice::Text) )
+        {
+            continue;
+        }
+
+        // Get value from line: PRETTY_NAME="<value>"
+        while ( !file.atEnd() )
+        {
+            QString line = QString( file.readLine() ).trimmed();
+            if ( line.startsWith("PRETTY_NAME=") )
+            {
+                QString value = line.mid( QString("PRETTY_NAME=").length() );
+                value.remove('"').remove('\'');
+
+                return value;
+            }
+        }
     }
 
-    // Get value from output: "Description:\t<value>\n"
-    QString releaseInfo = lsbRelease.readLine().split('\t').last();
-    releaseInfo = releaseInfo.split('\n').first();
+    return QString();
+}
 
-    return releaseInfo;
-#endif
+void Settings::storeOsVersion(const QString &version)
+{
+    osVersion = version;
+    settings->setValue("platform/os_version", version);
 }
 
 QString Settings::getWordSize() const
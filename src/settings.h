@@ -4,6 +4,8 @@
 #include <QtCore>
 #include <QNetworkAccessManager>
 
+class FileFetcher;
+
 class Settings : public QObject
 {
     Q_OBJECT
@@ -33,21 +35,42 @@ private:
     QSettings *settings;
 
     QNetworkAccessManager *nam;
+    FileFetcher *localDataFetcher;
 
     QHash<QString, QString> clients; // str_id, title
 
+    // Snapshot of the active client, rebuilt when clients change
+    QStringList clientNames;
+    QStringList clientCaptions;
+    int activeClientID;
+    QString activeClient;
+    QString clientDir;
+
+    mutable QHash<QString, QVariant> clientValues;
+
     QString dataPath;
     QString configPath;
 
     QString latestVersion;
+    QString osVersion;
 
     void log(const QString &text);
 
+    void loadClients();
+    void updateClientSnapshot();
+
+    QVariant loadClientValue(const QString &key, const QVariant &def) const;
+    void saveClientValue(const QString &key, const QVariant &value) const;
+
+    static QString readOsRelease();
+    void storeOsVersion(const QString &version);
+
 public:
     // Update URLs
     QString getVersionsUrl() const;
     QString getVanillaVersionsUrl() const;
     QString getVersionUrl(const QString &version);
+    QString getClientUrl() const;
     QString getLibsUrl() const;
     QString getAssetsUrl() const;
 
@@ -92,6 +115,15 @@ public:
     bool loadHideWindowModeState() const;
     void saveHideWindowModeState(bool hideState) const;
 
+    bool loadThrottleState() const;
+    void saveThrottleState(bool state) const;
+
+    // Download rate in KB/s while the game is running
+    int loadThrottleRate() const;
+
+    // Feedback server accepts the log as a multipart form file
+    bool loadFeedbackMultipartState() const;
+
     bool loadNewsState() const;
     void saveNewsState(bool state) const;
 
@@ -135,6 +167,42 @@ public:
     bool loadClientCheckAssetsState() const;
     void saveClientCheckAssetsState(bool state) const;
 
+    int loadClientClasspathMode() const;
+    void saveClientClasspathMode(int mode) const;
+
+    bool loadClientCdsState() const;
+    void saveClientCdsState(bool state) const;
+
+    int loadClientGameLogLevel() const;
+    void saveClientGameLogLevel(int level) const;
+
+    bool loadClientGcLogState() const;
+    void saveClientGcLogState(bool state) const;
+
+    bool loadClientJvmTuningState() const;
+    void saveClientJvmTuningState(bool state) const;
+
+    int loadClientHeapSize() const;
+    void saveClientHeapSize(int size) const;
+
+    int loadClientCollector() const;
+    void saveClientCollector(int collector) const;
+
+    bool loadClientSchedulingState() const;
+    void saveClientSchedulingState(bool state) const;
+
+    QString loadClientCpuAffinity() const;
+    void saveClientCpuAffinity(const QString &cpus) const;
+
+    int loadClientNiceLevel() const;
+    void saveClientNiceLevel(int level) const;
+
+    int loadClientIoClass() const;
+    void saveClientIoClass(int ioClass) const;
+
+    int loadClientMemoryLimit() const;
+    void saveClientMemoryLimit(int limit) const;
+
     // Local TtyhStore settings
     QString loadStoreExePath() const;
     void saveStoreExePath(const QString &path) const;
@@ -142,6 +210,9 @@ public:
     QString loadStoreDirPath() const;
     void saveStoreDirPath(const QString &path) const;
 
+    int loadStoreCopyMode() const;
+    void saveStoreCopyMode(int mode) const;
+
     // Custom
     QString makeMinecraftUuid() const;
 
@@ -152,11 +223,20 @@ public:
     QNetworkAccessManager *getNetworkAccessManager() const;
 
 public slots:
-    void saveActiveClientID(int id) const;
+    void saveActiveClientID(int id);
     void saveLogin(const QString &login) const;
     void savePassStoreState(bool state) const;
     void saveMaximizedState(bool state) const;
 
+private slots:
+    void localDataFetched(bool result);
+    void refreshOsVersion();
+
+signals:
+    // Cached data is loaded if the fetch failed
+    void localDataUpdated(bool result);
+    void activeClientChanged();
+
 private:
     Settings &operator=(Settings const &);
     Settings(Settings const &);
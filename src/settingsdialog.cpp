@@ -4,8 +4,13 @@
 #include <QFileDialog>
 #include <QDesktopServices>
 #include <QMessageBox>
+#include <QRegularExpressionValidator>
 
 #include "jsonparser.h"
+#include "launchpreparer.h"
+#include "jvmtuner.h"
+#include "gameprocess.h"
+#include "gamelog.h"
 
 SettingsDialog::SettingsDialog(QWidget *parent) :
     QDialog(parent),
@@ -16,6 +21,11 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
     settings = Settings::instance();
     logger = Logger::logger();
 
+    setupClasspathModes();
+    setupCollectors();
+    setupIoClasses();
+    setupGameLogLevels();
+
     ui->clientCombo->addItems( settings->getClientCaptions() );
     ui->clientCombo->setCurrentIndex( settings->loadActiveClientID() );
 
@@ -186,10 +196,87 @@ void SettingsDialog::logCurrentSettings()
     log( tr("\tCheckAssets: ")
          + (ui->checkAssetsCombo->isChecked() ? yes : no) );
 
+    log( tr("\tClassDataSharing: ")
+         + (ui->cdsCheckBox->isChecked() ? yes : no) );
+
+    log( tr("\tGcStatistics: ")
+         + (ui->gcLogCheckBox->isChecked() ? yes : no) );
+
+    log( tr("\tJvmTuning: ") + (ui->jvmBox->isChecked() ? yes : no) );
+    log( tr("\tHeapSize: ") + ui->heapSpinBox->text() );
+    log( tr("\tCollector: ") + ui->collectorCombo->currentText() );
+
+    log( tr("\tProcessScheduling: ")
+         + (ui->schedBox->isChecked() ? yes : no) );
+    log( tr("\tCpuAffinity: ") + ui->affinityEdit->text() );
+    log( tr("\tNiceLevel: ") + ui->niceSpinBox->text() );
+    log( tr("\tIoClass: ") + ui->ioClassCombo->currentText() );
+    log( tr("\tMemoryLimit: ") + ui->memoryLimitSpinBox->text() );
+
+    log( tr("\tClasspathMode: ")
+         + ui->classpathModeCombo->currentText() );
+
+    log( tr("\tGameLogLevel: ")
+         + ui->gameLogLevelCombo->currentText() );
+
     log( tr("\tUseJavaKeystore: ")
          + (ui->keystoreBox->isChecked() ? yes : no) );
 }
 
+void SettingsDialog::setupClasspathModes()
+{
+    ui->classpathModeCombo->addItem( tr("In command line, JAR if too long"),
+                                     LaunchPreparer::ClasspathAuto );
+    ui->classpathModeCombo->addItem( tr("In command line"),
+                                     LaunchPreparer::ClasspathCommandLine );
+    ui->classpathModeCombo->addItem( tr("In classpath JAR"),
+                                     LaunchPreparer::ClasspathJar );
+    ui->classpathModeCombo->addItem( tr("In argument file (Java 9+)"),
+                                     LaunchPreparer::ClasspathArgFile );
+}
+
+void SettingsDialog::setupCollectors()
+{
+    ui->collectorCombo->addItem( tr("Auto (G1 on multicore computers)"),
+                                 JvmTuner::CollectorAuto );
+    ui->collectorCombo->addItem( tr("G1 with short pauses"),
+                                 JvmTuner::CollectorG1 );
+    ui->collectorCombo->addItem( tr("ZGC (Java 15+)"),
+                                 JvmTuner::CollectorZ );
+    ui->collectorCombo->addItem( tr("Java default"),
+                                 JvmTuner::CollectorDefault );
+
+    int heapSize = JvmTuner::getRecommendedHeapSize();
+    if (heapSize > 0)
+    {
+        ui->heapSpinBox->setSpecialValueText( tr("Auto (%1)").arg(heapSize) );
+    }
+}
+
+void SettingsDialog::setupIoClasses()
+{
+    ui->ioClassCombo->addItem( tr("Default"), GameProcess::IoClassDefault );
+    ui->ioClassCombo->addItem( tr("Lowest normal"),
+                               GameProcess::IoClassBestEffort );
+    ui->ioClassCombo->addItem( tr("Idle only"), GameProcess::IoClassIdle );
+
+    QRegularExpression cpuList("[0-9,\\- ]*");
+    ui->affinityEdit->setValidator(
+        new QRegularExpressionValidator(cpuList, this) );
+}
+
+void SettingsDialog::setupGameLogLevels()
+{
+    ui->gameLogLevelCombo->addItem( tr("All, including debug"),
+                                    GameLog::LevelTrace );
+    ui->gameLogLevelCombo->addItem( tr("Information and above"),
+                                    GameLog::LevelInfo );
+    ui->gameLogLevelCombo->addItem( tr("Warnings and errors"),
+                                    GameLog::LevelWarn );
+    ui->gameLogLevelCombo->addItem( tr("Errors only"),
+                                    GameLog::LevelError );
+}
+
 bool SettingsDialog::isVersionInstalled(const QString &name)
 {
     QString prefix = settings->getClientDir() + "/prefixes/";
@@ -207,6 +294,24 @@ void SettingsDialog::saveSettings()
     settings->saveClientJavaArgsState( ui->argsBox->isChecked() );
     settings->saveClientJavaArgs( ui->argsEdit->text() );
 
+    settings->saveClientJvmTuningState( ui->jvmBox->isChecked() );
+    settings->saveClientHeapSize( ui->heapSpinBox->value() );
+
+    int collector = ui->collectorCombo->currentData().toInt();
+    settings->saveClientCollector(collector);
+
+    settings->saveClientSchedulingState( ui->schedBox->isChecked() );
+    settings->saveClientCpuAffinity( ui->affinityEdit->text() );
+    settings->saveClientNiceLevel( ui->niceSpinBox->value() );
+    settings->saveClientIoClass( ui->ioClassCombo->currentData().toInt() );
+    settings->saveClientMemoryLimit( ui->memoryLimitSpinBox->value() );
+
+    int classpathMode = ui->classpathModeCombo->currentData().toInt();
+    settings->saveClientClasspathMode(classpathMode);
+
+    int logLevel = ui->gameLogLevelCombo->currentData().toInt();
+    settings->saveClientGameLogLevel(logLevel);
+
     QRect g( -1, -1, ui->widthSpinBox->value(), ui->heightSpinBox->value() );
     settings->saveClientWindowGeometry(g);
 
@@ -222,6 +327,8 @@ void SettingsDialog::saveSettings()
     settings->saveClientJavaKeystorePass( ui->ksPassEdit->text() );
 
     settings->saveClientCheckAssetsState( ui->checkAssetsCombo->isChecked() );
+    settings->saveClientCdsState( ui->cdsCheckBox->isChecked() );
+    settings->saveClientGcLogState( ui->gcLogCheckBox->isChecked() );
 
     log( tr("Settings saved:") );
     logCurrentSettings();
@@ -236,6 +343,30 @@ void SettingsDialog::loadSettings()
     ui->argsBox->setChecked( settings->loadClientJavaArgsState() );
     ui->argsEdit->setText( settings->loadClientJavaArgs() );
 
+    ui->jvmBox->setChecked( settings->loadClientJvmTuningState() );
+    ui->heapSpinBox->setValue( settings->loadClientHeapSize() );
+
+    int collectorId = ui->collectorCombo->findData(
+        settings->loadClientCollector() );
+    ui->collectorCombo->setCurrentIndex(collectorId != -1 ? collectorId : 0);
+
+    ui->schedBox->setChecked( settings->loadClientSchedulingState() );
+    ui->affinityEdit->setText( settings->loadClientCpuAffinity() );
+    ui->niceSpinBox->setValue( settings->loadClientNiceLevel() );
+    ui->memoryLimitSpinBox->setValue( settings->loadClientMemoryLimit() );
+
+    int ioClassId = ui->ioClassCombo->findData(
+        settings->loadClientIoClass() );
+    ui->ioClassCombo->setCurrentIndex(ioClassId != -1 ? ioClassId : 0);
+
+    QComboBox *modeCombo = ui->classpathModeCombo;
+    int modeId = modeCombo->findData( settings->loadClientClasspathMode() );
+    modeCombo->setCurrentIndex(modeId != -1 ? modeId : 0);
+
+    QComboBox *levelCombo = ui->gameLogLevelCombo;
+    int levelId = levelCombo->findData( settings->loadClientGameLogLevel() );
+    levelCombo->setCurrentIndex(levelId != -1 ? levelId : 1);
+
     QRect g = settings->loadClientWindowGeometry();
     ui->widthSpinBox->setValue( g.width() );
     ui->heightSpinBox->setValue( g.height() );
@@ -260,6 +391,9 @@ void SettingsDialog::loadSettings()
     bool checkAssets = settings->loadClientCheckAssetsState();
     ui->checkAssetsCombo->setChecked(checkAssets);
 
+    ui->cdsCheckBox->setChecked( settings->loadClientCdsState() );
+    ui->gcLogCheckBox->setChecked( settings->loadClientGcLogState() );
+
     log( tr("Settings loaded:") );
     logCurrentSettings();
 }
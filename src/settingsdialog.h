@@ -36,6 +36,11 @@ private:
 
     bool isVersionInstalled(const QString &name);
 
+    void setupClasspathModes();
+    void setupCollectors();
+    void setupIoClasses();
+    void setupGameLogLevels();
+
 private slots:
     void saveSettings();
     void loadSettings();
@@ -2,7 +2,7 @@
 #include "../ui/ui_storeinstalldialog.h"
 
 #include "jsonparser.h"
-#include "hashchecker.h"
+#include "localversions.h"
 
 StoreInstallDialog::StoreInstallDialog(QWidget *parent) :
     QDialog(parent),
@@ -45,6 +45,7 @@ StoreInstallDialog::StoreInstallDialog(QWidget *parent) :
 
     setupLocalStoreVersions();
     setupPrefixes();
+    setupCopyModes();
 
     installing = false;
 }
@@ -135,10 +136,24 @@ void StoreInstallDialog::setupPrefixes()
     ui->prefixCombo->setCurrentIndex( settings->loadActiveClientID() );
 }
 
+void StoreInstallDialog::setupCopyModes()
+{
+    ui->copyModeCombo->addItem( tr("Fastest (clone or link files)"),
+                                FileInstaller::CopyAuto );
+    ui->copyModeCombo->addItem( tr("Fast (clone files, no links)"),
+                                FileInstaller::CopyNoLinks );
+    ui->copyModeCombo->addItem( tr("Plain copy"),
+                                FileInstaller::CopyPlain );
+
+    int id = ui->copyModeCombo->findData( settings->loadStoreCopyMode() );
+    ui->copyModeCombo->setCurrentIndex(id != -1 ? id : 0);
+}
+
 void StoreInstallDialog::setInteractable(bool state)
 {
     ui->versionCombo->setEnabled(state);
     ui->prefixCombo->setEnabled(state);
+    ui->copyModeCombo->setEnabled(state);
     ui->installButton->setEnabled(state);
 }
 
@@ -214,6 +229,10 @@ void StoreInstallDialog::installClicked()
 
     prepareAssets();
 
+    int mode = ui->copyModeCombo->currentData().toInt();
+    settings->saveStoreCopyMode(mode);
+    installer->setCopyMode( FileInstaller::CopyMode(mode) );
+
     log( tr("Begin copy files...") );
     setInteractable(false);
     emit install(installList);
@@ -330,7 +349,7 @@ void StoreInstallDialog::prepareAssets()
     InstallInfo assetsIdxInfo;
     assetsIdxInfo.srcPath = storeAssetsDir + "/indexes/" + assetsVer + ".json";
     assetsIdxInfo.path = clientAssetsDir + "/indexes/" + assetsVer + ".json";
-    assetsIdxInfo.hash = HashChecker::getFileHash(assetsIdxInfo.srcPath);
+    assetsIdxInfo.hash = "0";
     installList.append(assetsIdxInfo);
 
     QString assetsIdxPath = storeAssetsDir + "/indexes/" + assetsVer + ".json";
@@ -390,6 +409,8 @@ void StoreInstallDialog::installError(const InstallInfo &info)
 
 void StoreInstallDialog::installFinished()
 {
+    LocalVersions::update(clientDir + "/versions", storeVersion);
+
     log( tr("Installation finished!") );
     setInteractable(true);
     installList.clear();
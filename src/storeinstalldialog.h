@@ -36,6 +36,7 @@ private:
     void setupLocalStoreVersions();
     void getLocalPrefixVersions(const QString &prefix);
     void setupPrefixes();
+    void setupCopyModes();
 
     void setInteractable(bool state);
 
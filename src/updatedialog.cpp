@@ -4,6 +4,11 @@
 #include "settings.h"
 #include "logger.h"
 #include "util.h"
+#include "installmanifest.h"
+#include "localversions.h"
+
+// Percent of unchanged files verified by checksum in incremental checks
+static const int samplePercent = 5;
 
 UpdateDialog::UpdateDialog(QString displayMessage, QWidget *parent) :
     QDialog(parent),
@@ -33,6 +38,12 @@ UpdateDialog::UpdateDialog(QString displayMessage, QWidget *parent) :
     settings = Settings::instance();
     logger = Logger::logger();
 
+    deferredApply = false;
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
+    qsrand( uint( QDateTime::currentMSecsSinceEpoch() ) );
+#endif
+
     ui->clientCombo->addItems( settings->getClientCaptions() );
     ui->clientCombo->setCurrentIndex( settings->loadActiveClientID() );
 
@@ -69,6 +80,11 @@ UpdateDialog::UpdateDialog(QString displayMessage, QWidget *parent) :
     }
 }
 
+void UpdateDialog::setDeferredApply(bool state)
+{
+    deferredApply = state;
+}
+
 void UpdateDialog::log(const QString &line, bool hidden)
 {
     logger->appendLine(tr("UpdateDialog"), line);
@@ -87,6 +103,7 @@ void UpdateDialog::error(const QString &line)
 void UpdateDialog::setInteractable(bool state)
 {
     ui->clientCombo->setEnabled(state);
+    ui->fullCheckBox->setEnabled(state);
     ui->updateButton->setEnabled(state);
     ui->cancelButton->setEnabled(!state);
 }
@@ -94,9 +111,16 @@ void UpdateDialog::setInteractable(bool state)
 void UpdateDialog::resetUpdateData()
 {
     fileFetcher.reset();
+    transaction.rollback();
     checker->cancel();
     removeList.clear();
     checkList.clear();
+    baseline.clear();
+
+    addedCount = 0;
+    changedCount = 0;
+    unchangedCount = 0;
+    sampledCount = 0;
 }
 
 void UpdateDialog::setState(UpdaterState newState)
@@ -418,6 +442,25 @@ void UpdateDialog::assetsIndexReceived(bool result)
 
 void UpdateDialog::processIndexesData()
 {
+    QString clientPrefix = settings->getClientPrefix(clientVersion) + "/";
+    QString installedIndex = clientPrefix + "installed_data.json";
+
+    JsonParser installedParser;
+    bool installed = installedParser.setJsonFromFile(installedIndex);
+
+    if ( ui->fullCheckBox->isChecked() )
+    {
+        log( tr("Full check requested.") );
+    }
+    else if (installed)
+    {
+        loadBaseline(installedParser, installedIndex);
+    }
+    else
+    {
+        log( tr("Client is not installed, full check required.") );
+    }
+
     // I. JAR
     log( tr("Append main JAR to check list...") );
     if ( !dataParser.hasJarFileInfo() )
@@ -434,7 +477,7 @@ void UpdateDialog::processIndexesData()
     jar.size = dataParser.getJarFileInfo().size;
     jar.url = settings->getVersionUrl(clientVersion) + clientVersion + ".jar";
 
-    checkList.append(jar);
+    planFile(jar);
 
     // II. LIBS
     log( tr("Append libraries to checklist...") );
@@ -462,7 +505,7 @@ void UpdateDialog::processIndexesData()
         fileInfo.name = libDir + lib;
         fileInfo.url = libUrl + lib;
 
-        checkList.append(fileInfo);
+        planFile(fileInfo);
     }
 
     // III. ADDONS
@@ -473,7 +516,6 @@ void UpdateDialog::processIndexesData()
     }
 
     log( tr("Append addons to check-list...") );
-    QString clientPrefix = settings->getClientPrefix(clientVersion) + "/";
     QString addonsUrl = settings->getVersionUrl(clientVersion) + "files/";
 
     QList<FileInfo> addons = dataParser.getAddonsFilesInfo();
@@ -483,14 +525,11 @@ void UpdateDialog::processIndexesData()
         addon.name = clientPrefix + shortName;
         addon.url = addonsUrl + shortName;
 
-        checkList.append(addon);
+        planFile(addon);
     }
 
     log( tr("Checking for obsolete addons...") );
-    QString installedIndex = clientPrefix + "installed_data.json";
-
-    JsonParser installedParser;
-    if ( installedParser.setJsonFromFile(installedIndex) )
+    if (installed)
     {
         typedef QHash<QString, FileInfo> mapInfo;
 
@@ -531,13 +570,129 @@ void UpdateDialog::processIndexesData()
         asset.name = assetsDir + shortName;
         asset.url = assetsUrl + shortName;
 
-        checkList.append(asset);
+        planFile(asset);
     }
 
+    QString plan = tr("Update plan: %1 added, %2 changed, %3 removed, "
+                      "%4 of %5 unchanged files sampled.");
+    log( plan.arg(addedCount).arg(changedCount).arg( removeList.count() )
+             .arg(sampledCount).arg(unchangedCount) );
+
     log( tr("Checking files...") );
     emit checkFiles(checkList, false);
 }
 
+void UpdateDialog::loadBaseline(const JsonParser &installedParser,
+                                const QString &installedIndex)
+{
+    log( tr("Comparing with installed version...") );
+
+    QString clientPrefix = settings->getClientPrefix(clientVersion) + "/";
+    QString indexDir = settings->getVersionsDir() + "/" + clientVersion + "/";
+    QString libDir = settings->getLibsDir() + "/";
+
+    if ( installedParser.hasJarFileInfo() )
+    {
+        QString jar = indexDir + clientVersion + ".jar";
+        baseline.insert( jar, installedParser.getJarFileInfo().hash );
+    }
+
+    if ( installedParser.hasLibsFileInfo() )
+    {
+        foreach ( FileInfo lib, installedParser.getLibsFileInfo() )
+        {
+            baseline.insert(libDir + lib.name, lib.hash);
+        }
+    }
+
+    if ( installedParser.hasAddonsFilesInfo() )
+    {
+        foreach ( FileInfo addon, installedParser.getAddonsFilesInfo() )
+        {
+            baseline.insert(clientPrefix + addon.name, addon.hash);
+        }
+    }
+
+    // Installed data index is written last, so the local assets index
+    // describes installed files only if it is not newer
+    QString assetsName = versionParser.getAssetsVesrsion() + ".json";
+    QString assetsIndex = settings->getAssetsDir() + "/indexes/" + assetsName;
+
+    QFileInfo assetsIndexInfo(assetsIndex);
+    QFileInfo installedIndexInfo(installedIndex);
+
+    if ( !assetsIndexInfo.exists()
+         || assetsIndexInfo.lastModified() > installedIndexInfo.lastModified() )
+    {
+        log( tr("Assets index was changed, assets need full check."), true );
+        return;
+    }
+
+    JsonParser oldAssetsParser;
+    if ( oldAssetsParser.setJsonFromFile(assetsIndex)
+         && oldAssetsParser.hasAssetsList() )
+    {
+        QString assetsDir = settings->getAssetsDir() + "/objects/";
+        foreach ( FileInfo asset, oldAssetsParser.getAssetsList() )
+        {
+            baseline.insert(assetsDir + asset.name, asset.hash);
+        }
+    }
+}
+
+void UpdateDialog::planFile(const FileInfo &fileInfo)
+{
+    if ( !baseline.contains(fileInfo.name) )
+    {
+        addedCount++;
+        checkList.append(fileInfo);
+        return;
+    }
+
+    if ( baseline[fileInfo.name].toLower() != fileInfo.hash.toLower() )
+    {
+        changedCount++;
+        checkList.append(fileInfo);
+        return;
+    }
+
+    // Files unchanged since the last update are checked by metadata only
+    unchangedCount++;
+
+    QFileInfo localInfo(fileInfo.name);
+    bool sizeMatches = fileInfo.isMutable || fileInfo.size <= 0
+                       || localInfo.size() == fileInfo.size;
+
+    if ( !localInfo.exists() || !sizeMatches )
+    {
+        addToFetchList(fileInfo);
+        return;
+    }
+
+    if (fileInfo.isMutable)
+    {
+        return;
+    }
+
+    InstallManifest *manifest = InstallManifest::instance();
+    if ( manifest->isFileValid(fileInfo.name, fileInfo.hash) )
+    {
+        return;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    int sample = int( QRandomGenerator::global()->bounded(100) );
+#else
+    int sample = qrand() % 100;
+#endif
+
+    if (sample < samplePercent)
+    {
+        sampledCount++;
+        checkList.append(fileInfo);
+    }
+}
+
 void UpdateDialog::checkFinished()
 {
     log( tr("Done!") );
@@ -621,32 +776,67 @@ void UpdateDialog::updateComplete(bool result)
         {
             log( tr("Removing obsolete files...") );
 
-            int total = removeList.size();
-            int current = 1;
-
             foreach (QString entry, removeList)
             {
                 log(tr("Removing: ") + entry);
-                QFile::remove(clientDir + entry);
-
-                current++;
-                ui->progressBar->setValue( int(float(current) * 100 / total) );
+                transaction.remove(clientDir + entry);
             }
 
             removeList.clear();
         }
 
         // Update installed_data index
-        QFile::remove(clientDir + "installed_data.json");
-        QDir(clientDir).mkpath(clientDir);
-        QFile::copy(versionDir + "data.json",
-                    clientDir + "installed_data.json");
+        QString dataIndex = versionDir + "data.json";
+        QString newDataIndex = transaction.stagedPath(dataIndex);
+        if ( newDataIndex.isEmpty() )
+        {
+            newDataIndex = dataIndex;
+        }
+
+        QString installedIndex
+            = transaction.stage(clientDir + "installed_data.json");
+
+        QDir().mkpath( QFileInfo(installedIndex).absolutePath() );
+        QFile::remove(installedIndex);
+
+        if ( !QFile::copy(newDataIndex, installedIndex) )
+        {
+            transaction.rollback();
+
+            log( tr("Error! Can't stage %1").arg(installedIndex) );
+            log( tr("Update not completed! See launcher log for details.") );
 
+            setState(CanClose);
+            return;
+        }
+
+        log( tr("Applying update...") );
         ui->log->appendPlainText("");
-        log( tr("Update complete!") );
+
+        if ( transaction.commit(!deferredApply) )
+        {
+            QString versionsDir = settings->getVersionsDir();
+            LocalVersions::update(versionsDir, clientVersion);
+
+            if (deferredApply)
+            {
+                log( tr("Update downloaded, it will be applied "
+                        "when the game exits.") );
+            }
+            else
+            {
+                log( tr("Update complete!") );
+            }
+        }
+        else
+        {
+            log( tr("Update not completed! See launcher log for details.") );
+        }
     }
     else
     {
+        transaction.rollback();
+
         ui->log->appendPlainText("");
         log( tr("Update not completed. Some files was not downloaded.") );
     }
@@ -655,7 +845,8 @@ void UpdateDialog::updateComplete(bool result)
 
 void UpdateDialog::addToFetchList(const FileInfo fileInfo)
 {
-    fileFetcher.add(fileInfo.url, fileInfo.name, fileInfo.size);
+    QString stagePath = transaction.stage(fileInfo.name);
+    fileFetcher.add(fileInfo.url, stagePath, fileInfo.size);
 }
 
 UpdateDialog::~UpdateDialog()
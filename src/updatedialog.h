@@ -9,6 +9,7 @@
 #include "datafetcher.h"
 #include "jsonparser.h"
 #include "hashchecker.h"
+#include "updatetransaction.h"
 
 namespace Ui {
 class UpdateDialog;
@@ -22,6 +23,10 @@ public:
     explicit UpdateDialog(QString displayMessage, QWidget *parent = 0);
     ~UpdateDialog();
 
+    // Files are only staged while the game is running,
+    // the launcher applies them after the game exits
+    void setDeferredApply(bool state);
+
 private:
     Ui::UpdateDialog *ui;
     Settings *settings;
@@ -33,13 +38,24 @@ private:
     DataFetcher dataFetcher;
     FileFetcher fileFetcher;
 
+    UpdateTransaction transaction;
+
     JsonParser versionParser, dataParser, assetsParser;
 
     QString clientVersion;
+    bool deferredApply;
 
     QStringList removeList;
     QList<FileInfo> checkList;
 
+    // Hashes from the last complete update, by local file path
+    QHash<QString, QString> baseline;
+
+    int addedCount;
+    int changedCount;
+    int unchangedCount;
+    int sampledCount;
+
     enum UpdaterState {CanCheck, Checking, CanUpdate, Updating, CanClose};
 
     UpdaterState state;
@@ -57,6 +73,10 @@ private:
     void requestAssetsIndex();
     void processIndexesData();
 
+    void loadBaseline(const JsonParser &installedParser,
+                      const QString &installedIndex);
+    void planFile(const FileInfo &fileInfo);
+
     void doUpdate();
 
 signals:
@@ -0,0 +1,289 @@
+#include "updatetransaction.h"
+
+#include <cstdio>
+
+#include "settings.h"
+#include "logger.h"
+#include "util.h"
+#include "installmanifest.h"
+
+UpdateTransaction::UpdateTransaction(QObject *parent) : QObject(parent)
+{
+}
+
+void UpdateTransaction::log(const QString &text)
+{
+    Logger::logger()->appendLine(tr("UpdateTransaction"), text);
+}
+
+QString UpdateTransaction::stageDir()
+{
+    return Settings::instance()->getBaseDir() + "/staging";
+}
+
+QString UpdateTransaction::journalPath()
+{
+    return Settings::instance()->getBaseDir() + "/update_journal.json";
+}
+
+QString UpdateTransaction::stage(const QString &path)
+{
+    if ( staged.contains(path) )
+    {
+        return staged[path];
+    }
+
+    // Keep layout of the data directory for readable download logs
+    QString baseDir = Settings::instance()->getBaseDir() + "/";
+    QString stagePath;
+
+    if ( path.startsWith(baseDir) )
+    {
+        stagePath = stageDir() + "/" + path.mid( baseDir.length() );
+    }
+    else
+    {
+        // Files of a pending transaction may still be staged here
+        int number = targets.count();
+        do
+        {
+            stagePath = stageDir() + "/external/" + QString::number(number);
+            number++;
+        }
+        while ( QFile::exists(stagePath)
+                || staged.values().contains(stagePath) );
+    }
+
+    targets.append(path);
+    staged.insert(path, stagePath);
+
+    return stagePath;
+}
+
+QString UpdateTransaction::stagedPath(const QString &path) const
+{
+    return staged.value(path);
+}
+
+void UpdateTransaction::remove(const QString &path)
+{
+    removals.append(path);
+}
+
+bool UpdateTransaction::commit(bool applyNow)
+{
+    QJsonArray installs;
+    foreach (QString target, targets)
+    {
+        QJsonObject install;
+        install["from"] = staged[target];
+        install["to"] = target;
+
+        installs.append(install);
+    }
+
+    QStringList allRemovals = removals;
+
+    // Previous transaction failed to apply in this session,
+    // keep its steps which are not overridden by this one
+    if ( QFile::exists( journalPath() ) )
+    {
+        QJsonObject pending;
+        if ( !readJournal(&pending) )
+        {
+            return false;
+        }
+
+        log( tr("Merging with the pending update...") );
+
+        foreach ( QJsonValue value, pending["installs"].toArray() )
+        {
+            QString to = value.toObject()["to"].toString();
+            if ( !targets.contains(to) && !removals.contains(to) )
+            {
+                installs.append(value);
+            }
+        }
+
+        foreach ( QJsonValue value, pending["removals"].toArray() )
+        {
+            QString path = value.toString();
+            if ( !targets.contains(path) && !allRemovals.contains(path) )
+            {
+                allRemovals.append(path);
+            }
+        }
+    }
+
+    QJsonObject journal;
+    journal["installs"] = installs;
+    journal["removals"] = QJsonArray::fromStringList(allRemovals);
+
+    // Journal on disk means that transaction is committed
+    QSaveFile journalFile( journalPath() );
+    if ( !journalFile.open(QIODevice::WriteOnly) )
+    {
+        log( tr("Error! %1").arg( journalFile.errorString() ) );
+        return false;
+    }
+
+    journalFile.write( QJsonDocument(journal).toJson() );
+    if ( !journalFile.commit() )
+    {
+        log( tr("Error! %1").arg( journalFile.errorString() ) );
+        return false;
+    }
+
+    bool result = true;
+    if (applyNow)
+    {
+        result = apply(journal);
+    }
+    else
+    {
+        log( tr("Update is staged, it will be applied later.") );
+    }
+
+    targets.clear();
+    staged.clear();
+    removals.clear();
+
+    return result;
+}
+
+void UpdateTransaction::rollback()
+{
+    // Files of a committed transaction are kept until it is recovered
+    bool committed = QFile::exists( journalPath() );
+
+    if ( !committed && QFile::exists( stageDir() ) )
+    {
+        log( tr("Discarding staged files...") );
+        Util::removeAll( stageDir() );
+    }
+
+    targets.clear();
+    staged.clear();
+    removals.clear();
+}
+
+bool UpdateTransaction::hasPending()
+{
+    return QFile::exists( journalPath() );
+}
+
+void UpdateTransaction::recover()
+{
+    QFile journalFile( journalPath() );
+
+    if ( !journalFile.exists() )
+    {
+        // Files staged by an uncommitted transaction are useless
+        if ( QFile::exists( stageDir() ) )
+        {
+            log( tr("Removing files of an unfinished update...") );
+            Util::removeAll( stageDir() );
+        }
+        return;
+    }
+
+    log( tr("Finishing an interrupted update...") );
+
+    QJsonObject journal;
+    if ( readJournal(&journal) && apply(journal) )
+    {
+        log( tr("Interrupted update finished.") );
+    }
+}
+
+bool UpdateTransaction::readJournal(QJsonObject *journal)
+{
+    QFile journalFile( journalPath() );
+
+    if ( !journalFile.open(QIODevice::ReadOnly) )
+    {
+        log( tr("Error! %1").arg( journalFile.errorString() ) );
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(journalFile.readAll(), &error);
+    journalFile.close();
+
+    if (error.error != QJsonParseError::NoError)
+    {
+        // Journal is written atomically, so it can't be partial
+        log( tr("Error! Broken journal: %1").arg( error.errorString() ) );
+        return false;
+    }
+
+    *journal = json.object();
+    return true;
+}
+
+bool UpdateTransaction::apply(const QJsonObject &journal)
+{
+    bool result = true;
+    InstallManifest *manifest = InstallManifest::instance();
+
+    // Every step may be repeated if applying was interrupted
+    foreach ( QJsonValue value, journal["removals"].toArray() )
+    {
+        QString path = value.toString();
+        manifest->remove(path);
+
+        if ( QFile::exists(path) )
+        {
+            log( tr("Removing: %1").arg(path) );
+            if ( !QFile::remove(path) )
+            {
+                log( tr("Error! Can't remove %1").arg(path) );
+                result = false;
+            }
+        }
+    }
+
+    foreach ( QJsonValue value, journal["installs"].toArray() )
+    {
+        QJsonObject install = value.toObject();
+        QString from = install["from"].toString();
+        QString to = install["to"].toString();
+
+        if ( !QFile::exists(from) )
+        {
+            continue;
+        }
+
+        QDir().mkpath( QFileInfo(to).absolutePath() );
+        if ( !replaceFile(from, to) )
+        {
+            log( tr("Error! Can't replace %1").arg(to) );
+            result = false;
+        }
+    }
+
+    manifest->save();
+
+    if (result)
+    {
+        QFile::remove( journalPath() );
+        Util::removeAll( stageDir() );
+    }
+
+    return result;
+}
+
+bool UpdateTransaction::replaceFile(const QString &from, const QString &to)
+{
+    QByteArray fromName = QFile::encodeName(from);
+    QByteArray toName = QFile::encodeName(to);
+
+    // Atomic on POSIX systems, but fails for existing target on Windows
+    if (std::rename( fromName.constData(), toName.constData() ) == 0)
+    {
+        return true;
+    }
+
+    QFile::remove(to);
+    return QFile::rename(from, to);
+}
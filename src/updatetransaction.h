@@ -0,0 +1,45 @@
+#ifndef UPDATETRANSACTION_H
+#define UPDATETRANSACTION_H
+
+#include <QtCore>
+
+// Collects downloaded files in a staging directory and applies them
+// together with removals through a journal, so an interrupted update
+// never leaves a half-updated client
+class UpdateTransaction : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateTransaction(QObject *parent = 0);
+
+    QString stage(const QString &path);
+    QString stagedPath(const QString &path) const;
+    void remove(const QString &path);
+
+    // Steps of a pending transaction are merged into the new journal.
+    // Without applyNow only the journal is written, files are replaced
+    // later by recover()
+    bool commit(bool applyNow = true);
+    void rollback();
+
+    // Finish a transaction interrupted during commit or deferred
+    static void recover();
+    static bool hasPending();
+
+private:
+    QStringList targets;
+    QHash<QString, QString> staged;
+    QStringList removals;
+
+    static QString stageDir();
+    static QString journalPath();
+
+    static bool readJournal(QJsonObject *journal);
+    static bool apply(const QJsonObject &journal);
+    static bool replaceFile(const QString &from, const QString &to);
+
+    static void log(const QString &text);
+};
+
+#endif // UPDATETRANSACTION_H
@@ -3,46 +3,11 @@
 
 #include <quazip5/quazip.h>
 #include <quazip5/quazipfile.h>
-#include <quazip5/quacrc32.h>
 
 #include "util.h"
 #include "logger.h"
 #include "settings.h"
 
-// Based on: http://stackoverflow.com/questions/20734831
-QByteArray Util::makeGzip(const QByteArray &data)
-{
-    // Compress data
-    QByteArray compressedData = qCompress(data);
-
-    // Strip the first six bytes
-    // (a 4-byte length put on by qCompress and a 2-byte zlib header)
-    // and the last four bytes (a zlib integrity check).
-    compressedData.remove(0, 6);
-    compressedData.chop(4);
-
-    // Make a generic 10-byte gzip header (see RFC 1952)
-    QByteArray header;
-    QDataStream headerStream(&header, QIODevice::WriteOnly);
-
-    headerStream << quint16(0x1f8b)
-                 << quint16(0x0800)
-                 << quint16(0x0000)
-                 << quint16(0x0000)
-                 << quint16(0x000b);
-
-    // Append a four-byte CRC-32 of the uncompressed data
-    // Append 4 bytes uncompressed input size modulo 2^32
-    QByteArray footer;
-    QDataStream footerStream(&footer, QIODevice::WriteOnly);
-    footerStream.setByteOrder(QDataStream::LittleEndian);
-
-    QuaCrc32 crc32;
-    footerStream << crc32.calculate(data) << quint32( data.size() );
-
-    return header + compressedData + footer;
-}
-
 void Util::removeAll(const QString &filePath)
 {
     log( QApplication::translate("Util", "Delete: %1").arg(filePath) );
@@ -6,8 +6,6 @@
 class Util
 {
 public:
-    static QByteArray makeGzip(const QByteArray &data);
-
     static QString getCommandOutput(const QString &command,
                                     const QStringList &args);
 